@@ -2,1051 +2,6717 @@
 #include "ns3/network-module.h"
 #include "ns3/internet-module.h"
 #include "ns3/point-to-point-module.h"
+#include "ns3/csma-module.h"
 #include "ns3/applications-module.h"
 #include "ns3/netanim-module.h"
 #include "ns3/nix-vector-helper.h"
+#ifdef NS3_MPI
+#include "ns3/mpi-interface.h"
+#include <mpi.h>
+#endif
 #include <vector>
 #include <map>
+#include <unordered_set>
+#include <list>
 #include <cmath>
+#include <limits>
 #include <algorithm>
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <queue>
+#include <thread>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
 
 using namespace ns3;
 using namespace std;
 
 NS_LOG_COMPONENT_DEFINE ("ChordProtocol");
 
-// Struttura per i messaggi Chord
-struct ChordMessage {
-    enum MessageType {
-        LOOKUP_REQUEST,
-        LOOKUP_RESPONSE,
-        STORE_FILE,
-        STORE_ACK
-    };
-    
-    MessageType type;
-    uint32_t senderId;      // ID del nodo che invia il messaggio
-    uint32_t originId;      // ID del nodo che ha avviato il lookup (per inviare la risposta direttamente)
-    uint32_t targetId;      // chordId del file o del nodo target
-    uint32_t hopCount;
-    bool success;
-};
-
-// Struttura per i nodi Chord
-struct ChordNode {
-    uint32_t chordId;
-    std::vector<uint32_t> fingerTable;
-    std::vector<uint32_t> successorList;
-    uint32_t predecessor;
-    std::set<uint32_t> storedFiles;
-    bool isAlive;
-    Ptr<Node> nsNode;     // Riferimento al nodo fisico
+// Identificatori dell'anello. La larghezza si sceglie in compilazione con -DCHORD_ID_BITS:
+// 32 (predefinita) e 64 usano gli interi nativi, 128 e 160 (la larghezza di SHA-1 del Chord
+// originale) WideId. Lo spazio effettivo ha m <= CHORD_ID_BITS bit
+#ifndef CHORD_ID_BITS
+#define CHORD_ID_BITS 32
+#endif
 
-    ChordNode(uint32_t id, Ptr<Node> node) : chordId(id), isAlive(true), nsNode(node) {}
-};
+// Intero senza segno a Bits bit con aritmetica modulo 2^Bits, in parole da 32 bit a partire
+// dalla meno significativa
+template <uint32_t Bits>
+class WideId {
+public:
+    static_assert(Bits % 32 == 0 && Bits > 64, "WideId serve solo oltre i 64 bit");
+    static const uint32_t WORDS = Bits / 32;
 
-class ChordApplication : public Application {
-private:
-    uint32_t chordId;
-    uint32_t port;
-    Ptr<Socket> socket;
-    std::vector<uint32_t> fingerTable;
-    std::vector<uint32_t> successorList;
-    uint32_t predecessor;
-    std::map<uint32_t, Address> nodeAddresses;
-    std::set<uint32_t> storedFiles;
-    bool isAlive;
-    
-    struct LookupInfo {
-        uint32_t lookupId;
-        uint32_t fileId;
-        EventId timeoutEvent;
-    };
-    std::map<uint32_t, LookupInfo> pendingLookups;
-    
-    typedef Callback<void, bool, uint32_t, uint32_t> StatsCallback;
-    StatsCallback statsCallback;
+    WideId() : words() {}
 
-public:
-    static TypeId GetTypeId(void) {
-        static TypeId tid = TypeId("ChordApplication")
-            .SetParent<Application>()
-            .AddConstructor<ChordApplication>();
-        return tid;
+    WideId(uint64_t value) : words() {
+        words[0] = (uint32_t)value;
+        words[1] = (uint32_t)(value >> 32);
     }
-    
-    static uint32_t nextLookupId;
 
-    ChordApplication() : port(9), isAlive(true) {
+    uint64_t Low64() const {
+        return words[0] | ((uint64_t)words[1] << 32);
     }
 
-    void Setup(uint32_t id, const std::vector<uint32_t>& ft, 
-               const std::vector<uint32_t>& sl, uint32_t pred) {
-        chordId = id;
-        fingerTable = ft;
-        successorList = sl;
-        predecessor = pred;
-        
-        cout << "Node " << chordId << " initialized with " 
-             << fingerTable.size() << " finger table entries and "
-             << "1 successore (ID: " << (successorList.empty() ? 0 : successorList[0]) << ")" << endl;
+    double ToDouble() const {
+        double value = 0.0;
+        for (uint32_t i = WORDS; i-- > 0;) {
+            value = value * 4294967296.0 + words[i];
+        }
+        return value;
     }
 
-    void AddNodeAddress(uint32_t nodeId, const Address& address) {
-        nodeAddresses[nodeId] = address;
+    bool operator==(const WideId& other) const {
+        for (uint32_t i = 0; i < WORDS; i++) {
+            if (words[i] != other.words[i]) {
+                return false;
+            }
+        }
+        return true;
     }
 
-    void StartApplication() override {
-        cout << "ChordApplication::StartApplication - Node " << chordId << endl;
-        socket = Socket::CreateSocket(GetNode(), UdpSocketFactory::GetTypeId());
-        InetSocketAddress local = InetSocketAddress(Ipv4Address::GetAny(), port);
-        socket->Bind(local);
-        socket->SetRecvCallback(MakeCallback(&ChordApplication::HandleRead, this));
-        cout << "Node " << chordId << " application started" << endl;
+    bool operator<(const WideId& other) const {
+        for (uint32_t i = WORDS; i-- > 0;) {
+            if (words[i] != other.words[i]) {
+                return words[i] < other.words[i];
+            }
+        }
+        return false;
     }
 
-    void StopApplication() override {
-        cout << "ChordApplication::StopApplication - Node " << chordId << endl;
-        if (socket) {
-            socket->Close();
+    bool operator!=(const WideId& other) const { return !(*this == other); }
+    bool operator>(const WideId& other) const { return other < *this; }
+    bool operator<=(const WideId& other) const { return !(other < *this); }
+    bool operator>=(const WideId& other) const { return !(*this < other); }
+
+    WideId operator+(const WideId& other) const {
+        WideId result;
+        uint64_t carry = 0;
+        for (uint32_t i = 0; i < WORDS; i++) {
+            uint64_t sum = (uint64_t)words[i] + other.words[i] + carry;
+            result.words[i] = (uint32_t)sum;
+            carry = sum >> 32;
         }
-        cout << "Il nodo " << chordId << " è spento" << endl;
+        return result;
     }
 
-    bool IsStarted() const {
-        return (socket != nullptr);
+    WideId operator-(const WideId& other) const {
+        WideId result;
+        uint64_t borrow = 0;
+        for (uint32_t i = 0; i < WORDS; i++) {
+            uint64_t difference = (uint64_t)words[i] - other.words[i] - borrow;
+            result.words[i] = (uint32_t)difference;
+            borrow = (difference >> 32) != 0 ? 1 : 0;
+        }
+        return result;
     }
 
-    void SetAlive(bool alive) {
-        cout << "ChordApplication::SetAlive - Node " << chordId << " alive: " << alive << endl;
-        isAlive = alive;
-        if (!alive) {
-            cout << "Node " << chordId << " è ora spento" << endl;
+    WideId operator&(const WideId& other) const {
+        WideId result;
+        for (uint32_t i = 0; i < WORDS; i++) {
+            result.words[i] = words[i] & other.words[i];
         }
+        return result;
     }
 
-    void SendMessage(Ptr<Packet> packet, Address targetAddress) {
-        if (!isAlive || !socket) {
-            cout << "WARN: Il nodo " << chordId << " non può inviare un messaggio: " 
-                 << (isAlive ? "socket è nullo" : "il nodo è spento") << endl;
-            return;
+    WideId operator|(const WideId& other) const {
+        WideId result;
+        for (uint32_t i = 0; i < WORDS; i++) {
+            result.words[i] = words[i] | other.words[i];
         }
-
-        ChordMessage msg;
-        packet->CopyData((uint8_t*)&msg, sizeof(ChordMessage));
-        
-        cout << "Il nodo " << chordId << " sta inviando un messaggio " 
-             << GetMessageTypeName(msg.type) << " a "
-             << InetSocketAddress::ConvertFrom(targetAddress).GetIpv4()
-             << " [targetId: " << msg.targetId 
-             << ", hops: " << msg.hopCount << "]" << endl;
-        
-        socket->SendTo(packet, 0, targetAddress);
+        return result;
     }
 
-    uint32_t FindNextHop(uint32_t targetId) {
-        cout << "DEBUG: Il nodo " << chordId << " cerca il prossimo nodo per targetId " << targetId << endl;
-        cout << "DEBUG: Finger table: ";
-        for (size_t i = 0; i < fingerTable.size(); i++) {
-            cout << fingerTable[i] << " ";
+    WideId operator<<(uint32_t shift) const {
+        WideId result;
+        if (shift >= Bits) {
+            return result;
         }
-        cout << endl;
-        
-        if (targetId == chordId) {
-            cout << "DEBUG: Il target ID è uguale al nostro ID, ritorniamo noi stessi" << endl;
-            return chordId;
-        }
-        
-        if (IsInRange(targetId, chordId, fingerTable[0])) {
-            cout << "DEBUG: Il target " << targetId << " è nel range tra " << chordId << " e " << fingerTable[0] << endl;
-            return fingerTable[0];
+        uint32_t wordShift = shift / 32;
+        uint32_t bitShift = shift % 32;
+        for (uint32_t i = wordShift; i < WORDS; i++) {
+            uint32_t value = words[i - wordShift] << bitShift;
+            if (bitShift > 0 && i > wordShift) {
+                value |= words[i - wordShift - 1] >> (32 - bitShift);
+            }
+            result.words[i] = value;
         }
+        return result;
+    }
 
-        for (int i = fingerTable.size() - 1; i >= 0; i--) {
-            if (IsInRange(fingerTable[i], chordId, targetId)) {
-                cout << "DEBUG: Trovato nodo " << fingerTable[i] << " nel range per target " << targetId << endl;
-                return fingerTable[i];
+    WideId operator>>(uint32_t shift) const {
+        WideId result;
+        if (shift >= Bits) {
+            return result;
+        }
+        uint32_t wordShift = shift / 32;
+        uint32_t bitShift = shift % 32;
+        for (uint32_t i = 0; i + wordShift < WORDS; i++) {
+            uint32_t value = words[i + wordShift] >> bitShift;
+            if (bitShift > 0 && i + wordShift + 1 < WORDS) {
+                value |= words[i + wordShift + 1] << (32 - bitShift);
             }
+            result.words[i] = value;
         }
-
-        cout << "DEBUG: Nessun nodo trovato nella finger table, ritorniamo il successore " << fingerTable[0] << endl;
-        return fingerTable[0];
+        return result;
     }
 
-    void SetStatsCallback(StatsCallback callback) {
-        statsCallback = callback;
+    // Azzera i bit dal bits-esimo in su, cioè riduce modulo 2^bits
+    WideId Truncate(uint32_t bits) const {
+        WideId result = *this;
+        for (uint32_t i = bits / 32; i < WORDS; i++) {
+            result.words[i] = bits % 32 != 0 && i == bits / 32 ? words[i] & ((1u << (bits % 32)) - 1) : 0;
+        }
+        return result;
     }
 
-    void PerformLookup(uint32_t fileId, Time timeout, uint32_t lookupId) {
-        cout << "ChordApplication::PerformLookup - Node " << chordId << " fileId: " << fileId << " lookupId: " << lookupId << endl;
-        
-        if (!isAlive || !socket) {
-            cout << "WARN: Node " << chordId << " cannot perform lookup: " 
-                 << (isAlive ? "socket is null" : "node is down") << endl;
-            if (!statsCallback.IsNull()) {
-                statsCallback(false, 0, lookupId);
-            }
-            return;
-        }
-        
-        // Stampiamo tutti i file memorizzati da questo nodo
-        cout << "DEBUG: Node " << chordId << " ha " << storedFiles.size() << " file memorizzati: ";
-        for (const uint32_t fileId : storedFiles) {
-            cout << fileId << " ";
-        }
-        cout << endl;
-        
-        // Verifica se abbiamo già il file localmente
-        if (storedFiles.count(fileId) > 0) {
-            cout << "Node " << chordId << " already has file " << fileId << " locally" << endl;
-            if (!statsCallback.IsNull()) {
-                statsCallback(true, 0, lookupId);
-            }
-            return;
+    size_t Hash() const {
+        uint64_t hash = 14695981039346656037ull;
+        for (uint32_t i = 0; i < WORDS; i++) {
+            hash = (hash ^ words[i]) * 1099511628211ull;
         }
-        
-        uint32_t nextHop = FindNextHop(fileId);
-        
-        if (nextHop == chordId) {
-            cout << "WARN: FindNextHop ha restituito il nodo corrente. Possibile errore nella finger table." << endl;
-            if (!statsCallback.IsNull()) {
-                statsCallback(false, 0, lookupId);
-            }
-            return;
+        return (size_t)hash;
+    }
+
+    // Esadecimale senza zeri iniziali
+    friend std::ostream& operator<<(std::ostream& os, const WideId& id) {
+        std::ostringstream text;
+        text << "0x" << std::hex;
+        uint32_t i = WORDS;
+        while (i > 1 && id.words[i - 1] == 0) {
+            i--;
         }
-        
-        ChordMessage msg;
-        msg.type = ChordMessage::LOOKUP_REQUEST;
-        msg.senderId = chordId;
-        msg.originId = chordId;  // Il nodo che avvia il lookup è anche l'origine
-        msg.targetId = fileId;
-        msg.hopCount = 0;
-        msg.success = false;
-        
-        Ptr<Packet> packet = Create<Packet>((uint8_t*)&msg, sizeof(ChordMessage));
-        
-        if (nodeAddresses.find(nextHop) != nodeAddresses.end()) {
-            cout << "Il nodo " << chordId << " sta iniziando una lookup " << lookupId << " per il file " << fileId 
-                 << "contattando il nodo " << nextHop << endl;
-            
-            EventId timeoutEvent = Simulator::Schedule(timeout, &ChordApplication::HandleLookupTimeout, this, fileId, lookupId);
-            
-            // Salva le informazioni del lookup
-            LookupInfo info;
-            info.fileId = fileId;
-            info.lookupId = lookupId;
-            info.timeoutEvent = timeoutEvent;
-            pendingLookups[fileId] = info;
-            
-            SendMessage(packet, nodeAddresses[nextHop]);
-        } else {
-            cout << "ERROR: Il nodo " << chordId << " non può trovare l'indirizzo del prossimo nodo " << nextHop << endl;
-            if (!statsCallback.IsNull()) {
-                statsCallback(false, 0, lookupId);
-            }
+        text << id.words[--i];
+        while (i-- > 0) {
+            text << std::setw(8) << std::setfill('0') << id.words[i];
         }
+        return os << text.str();
     }
 
 private:
-    void HandleRead(Ptr<Socket> socket) {
-        if (!isAlive) return;
+    uint32_t words[WORDS];
+};
 
-        Ptr<Packet> packet;
-        Address from;
-        while ((packet = socket->RecvFrom(from))) {
-            ChordMessage msg;
-            packet->CopyData((uint8_t*)&msg, sizeof(ChordMessage));
+namespace std {
+template <uint32_t Bits>
+struct hash<WideId<Bits>> {
+    size_t operator()(const WideId<Bits>& id) const {
+        return id.Hash();
+    }
+};
+}
 
-            cout << "Il nodo " << chordId << " ha ricevuto un messaggio di tipo" 
-                 << GetMessageTypeName(msg.type) << " dal nodo " 
-                 << msg.senderId << " [targetId: " << msg.targetId 
-                 << ", hops: " << msg.hopCount << "]" << endl;
+#if CHORD_ID_BITS == 32
+typedef uint32_t ChordId;
+#elif CHORD_ID_BITS == 64
+typedef uint64_t ChordId;
+#elif CHORD_ID_BITS == 128 || CHORD_ID_BITS == 160
+typedef WideId<CHORD_ID_BITS> ChordId;
+#else
+#error "CHORD_ID_BITS deve valere 32, 64, 128 o 160"
+#endif
 
-            switch (msg.type) {
-                case ChordMessage::LOOKUP_REQUEST:
-                    HandleLookup(msg, from);
-                    break;
-                case ChordMessage::LOOKUP_RESPONSE:
-                    HandleLookupResponse(msg);
-                    break;
-                case ChordMessage::STORE_FILE:
-                    HandleStore(msg, from);
-                    break;
-                default:
-                    break;
-            }
-        }
-    }
+inline uint64_t IdLow64(uint64_t id) {
+    return id;
+}
 
-    void HandleLookup(const ChordMessage& msg, const Address& from) {
-        cout << "ChordApplication::HandleLookup - Node " << chordId << " targetId: " << msg.targetId << endl;
+template <uint32_t Bits>
+inline uint64_t IdLow64(const WideId<Bits>& id) {
+    return id.Low64();
+}
 
-        if (msg.hopCount > 50) { 
-            cout << "WARN: Rilevato possibile ciclo di routing per il file " << msg.targetId 
-                 << " dopo " << msg.hopCount << " hop. Interrompo la ricerca." << endl;
-            
-            ChordMessage response;
-            response.type = ChordMessage::LOOKUP_RESPONSE;
-            response.senderId = chordId;
-            response.originId = msg.originId;
-            response.targetId = msg.targetId;
-            response.success = false;
-            response.hopCount = msg.hopCount;
-
-            if (nodeAddresses.find(msg.originId) != nodeAddresses.end()) {
-                Ptr<Packet> packet = Create<Packet>((uint8_t*)&response, sizeof(ChordMessage));
-                SendMessage(packet, nodeAddresses[msg.originId]);
-                cout << "DEBUG: Inviata risposta negativa direttamente al nodo originale " << msg.originId << endl;
-            } else {
-                Ptr<Packet> packet = Create<Packet>((uint8_t*)&response, sizeof(ChordMessage));
-                SendMessage(packet, from);
-                cout << "DEBUG: Inviata risposta negativa al mittente (non trovato indirizzo del nodo originale)" << endl;
-            }
-            return;
-        }
+inline double IdToDouble(uint64_t id) {
+    return (double)id;
+}
 
-        cout << "DEBUG: Il nodo " << chordId << " ha " << storedFiles.size() << " file memorizzati: ";
-        for (const uint32_t fileId : storedFiles) {
-            cout << fileId << " ";
-        }
-        cout << endl;
+template <uint32_t Bits>
+inline double IdToDouble(const WideId<Bits>& id) {
+    return id.ToDouble();
+}
 
-        if (storedFiles.find(msg.targetId) != storedFiles.end()) {
-            cout << "Il nodo " << chordId << " ha il file " << msg.targetId 
-                 << ". Inviamo la risposta dopo " << msg.hopCount << " hop" << endl;
-
-            ChordMessage response;
-            response.type = ChordMessage::LOOKUP_RESPONSE;
-            response.senderId = chordId;
-            response.originId = msg.originId;
-            response.targetId = msg.targetId;
-            response.success = true;
-            response.hopCount = msg.hopCount + 1;
-
-            if (nodeAddresses.find(msg.originId) != nodeAddresses.end()) {
-                Ptr<Packet> packet = Create<Packet>((uint8_t*)&response, sizeof(ChordMessage));
-                SendMessage(packet, nodeAddresses[msg.originId]);
-                cout << "DEBUG: Inviata risposta positiva direttamente al nodo originale " << msg.originId << endl;
-            } else {
-                Ptr<Packet> packet = Create<Packet>((uint8_t*)&response, sizeof(ChordMessage));
-                SendMessage(packet, from);
-                cout << "DEBUG: Inviata risposta positiva al mittente (non trovato indirizzo del nodo originale)" << endl;
-            }
-            return;
-        } else {
-            cout << "DEBUG: Node " << chordId << " NON ha il file " << msg.targetId << endl;
-        }
+// 2^i, con i < CHORD_ID_BITS
+inline ChordId IdPow2(uint32_t i) {
+    return ChordId(1) << i;
+}
 
-        uint32_t nextHop = FindNextHop(msg.targetId);
-        
-        if (nextHop == chordId) {
-            cout << "WARN: FindNextHop ha restituito il nodo corrente. Possibile errore nella finger table." << endl;
-            
-            ChordMessage response;
-            response.type = ChordMessage::LOOKUP_RESPONSE;
-            response.senderId = chordId;
-            response.originId = msg.originId;
-            response.targetId = msg.targetId;
-            response.success = false;
-            response.hopCount = msg.hopCount;
-
-            if (nodeAddresses.find(msg.originId) != nodeAddresses.end()) {
-                Ptr<Packet> packet = Create<Packet>((uint8_t*)&response, sizeof(ChordMessage));
-                SendMessage(packet, nodeAddresses[msg.originId]);
-                cout << "DEBUG: Inviata risposta negativa direttamente al nodo originale " << msg.originId << endl;
-            } else {
-                Ptr<Packet> packet = Create<Packet>((uint8_t*)&response, sizeof(ChordMessage));
-                SendMessage(packet, from);
-                cout << "DEBUG: Inviata risposta negativa al mittente (non trovato indirizzo del nodo originale)" << endl;
-            }
-            return;
-        }
-        
-        if (nextHop != chordId) {
-            cout << "Il nodo " << chordId << " sta inoltrando una lookup per il file " 
-                 << msg.targetId << " al nodo " << nextHop << endl;
-
-            ChordMessage forward = msg;
-            forward.senderId = chordId;
-            forward.hopCount++;
-            Ptr<Packet> packet = Create<Packet>((uint8_t*)&forward, sizeof(ChordMessage));
-            
-            if (nodeAddresses.find(nextHop) != nodeAddresses.end()) {
-                SendMessage(packet, nodeAddresses[nextHop]);
-            } else {
-                cout << "ERROR: Impossibile trovare l'indirizzo per il nodo " << nextHop << endl;
-                
-                ChordMessage response;
-                response.type = ChordMessage::LOOKUP_RESPONSE;
-                response.senderId = chordId;
-                response.originId = msg.originId;
-                response.targetId = msg.targetId;
-                response.success = false;
-                response.hopCount = msg.hopCount;
-
-                if (nodeAddresses.find(msg.originId) != nodeAddresses.end()) {
-                    Ptr<Packet> packet = Create<Packet>((uint8_t*)&response, sizeof(ChordMessage));
-                    SendMessage(packet, nodeAddresses[msg.originId]);
-                    cout << "DEBUG: Inviata risposta negativa direttamente al nodo originale " << msg.originId << endl;
-                } else {
-                    Ptr<Packet> packet = Create<Packet>((uint8_t*)&response, sizeof(ChordMessage));
-                    SendMessage(packet, from);
-                    cout << "DEBUG: Inviata risposta negativa al mittente (non trovato indirizzo del nodo originale)" << endl;
-                }
-            }
-        }
+// Riduce un identificatore allo spazio di m bit
+template <typename T>
+inline T IdMask(T id, uint32_t m) {
+    return m >= sizeof(T) * 8 ? id : (id & ((T(1) << m) - 1));
+}
+
+template <uint32_t Bits>
+inline WideId<Bits> IdMask(const WideId<Bits>& id, uint32_t m) {
+    return id.Truncate(m);
+}
+
+// Somma e differenza modulo 2^m: quelle native sono già modulo 2^CHORD_ID_BITS, multiplo di 2^m
+inline ChordId IdAdd(ChordId a, ChordId b, uint32_t m) {
+    return IdMask(a + b, m);
+}
+
+inline ChordId IdSub(ChordId a, ChordId b, uint32_t m) {
+    return IdMask(a - b, m);
+}
+
+// Identificatore uniforme in [0, 2^m), estratto 32 bit alla volta: con m <= 32 è una sola
+// estrazione come per gli ID a 32 bit
+inline ChordId RandomId(Ptr<UniformRandomVariable> rng, uint32_t m) {
+    ChordId id = 0;
+    for (uint32_t low = 0; low < m; low += 32) {
+        uint32_t bits = std::min<uint32_t>(32, m - low);
+        uint32_t max = bits == 32 ? UINT32_MAX : (1u << bits) - 1;
+        id = id | (ChordId(rng->GetInteger(0, max)) << low);
     }
+    return id;
+}
 
-    void HandleLookupResponse(const ChordMessage& msg) {
-        cout << "ChordApplication::HandleLookupResponse - Node " << chordId << " targetId: " << msg.targetId << endl;
-        cout << "Il nodo " << chordId << " ha ricevuto una risposta per il file " 
-             << msg.targetId << " dopo " << msg.hopCount << " hop" << endl;
-        
-        if (msg.originId != chordId) {
-            cout << "WARN: Il nodo " << chordId << " ha ricevuto una risposta per un lookup che non ha avviato. OriginId: " << msg.originId << endl;
-            return;
+// SHA-1 (FIPS 180-1), usata per ricavare gli identificatori dalle chiavi testuali
+void Sha1Digest(const std::string& data, uint8_t digest[20]) {
+    auto rotate = [](uint32_t value, uint32_t bits) { return (value << bits) | (value >> (32 - bits)); };
+    uint32_t h[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+    std::string message = data;
+    uint64_t bitLength = (uint64_t)data.size() * 8;
+    message.push_back((char)0x80);
+    while (message.size() % 64 != 56) {
+        message.push_back(0);
+    }
+    for (int i = 7; i >= 0; i--) {
+        message.push_back((char)(bitLength >> (i * 8)));
+    }
+    for (size_t chunk = 0; chunk < message.size(); chunk += 64) {
+        uint32_t w[80];
+        for (uint32_t i = 0; i < 16; i++) {
+            const uint8_t* bytes = (const uint8_t*)message.data() + chunk + 4 * i;
+            w[i] = ((uint32_t)bytes[0] << 24) | ((uint32_t)bytes[1] << 16) | ((uint32_t)bytes[2] << 8) | bytes[3];
         }
-        
-        map<uint32_t, ChordApplication::LookupInfo>::iterator it = pendingLookups.find(msg.targetId);
-        if (it != pendingLookups.end()) {
-            Simulator::Cancel(it->second.timeoutEvent);
-            
-            if (!statsCallback.IsNull()) {
-                cout << "DEBUG: Il nodo " << chordId << " aggiorna le statistiche per il lookup " << it->second.lookupId 
-                     << " (success: " << (msg.success ? "true" : "false") << ", hops: " << msg.hopCount << ")" << endl;
-                statsCallback(msg.success, msg.hopCount, it->second.lookupId);
+        for (uint32_t i = 16; i < 80; i++) {
+            w[i] = rotate(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+        }
+        uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+        for (uint32_t i = 0; i < 80; i++) {
+            uint32_t f, k;
+            if (i < 20) {
+                f = (b & c) | (~b & d);
+                k = 0x5A827999;
+            } else if (i < 40) {
+                f = b ^ c ^ d;
+                k = 0x6ED9EBA1;
+            } else if (i < 60) {
+                f = (b & c) | (b & d) | (c & d);
+                k = 0x8F1BBCDC;
             } else {
-                cout << "ERROR: Il nodo " << chordId << " non ha una callback per le statistiche!" << endl;
+                f = b ^ c ^ d;
+                k = 0xCA62C1D6;
             }
-            
-            pendingLookups.erase(it);
-        } else {
-            cout << "WARN: Il nodo " << chordId << " ha ricevuto una risposta per un lookup non pendente. FileId: " << msg.targetId << endl;
+            uint32_t temp = rotate(a, 5) + f + e + k + w[i];
+            e = d;
+            d = c;
+            c = rotate(b, 30);
+            b = a;
+            a = temp;
         }
+        h[0] += a;
+        h[1] += b;
+        h[2] += c;
+        h[3] += d;
+        h[4] += e;
     }
+    for (uint32_t i = 0; i < 5; i++) {
+        digest[4 * i] = (uint8_t)(h[i] >> 24);
+        digest[4 * i + 1] = (uint8_t)(h[i] >> 16);
+        digest[4 * i + 2] = (uint8_t)(h[i] >> 8);
+        digest[4 * i + 3] = (uint8_t)h[i];
+    }
+}
 
-    void HandleStore(const ChordMessage& msg, const Address& from) {
-        cout << "ChordApplication::HandleStore - Node " << chordId << " targetId: " << msg.targetId << endl;
+// Identificatore di una chiave: SHA-1 modulo 2^m, come nel Chord originale. Gli ultimi
+// CHORD_ID_BITS / 8 byte del digest, letti in big-endian, sono il digest modulo 2^CHORD_ID_BITS
+ChordId HashKey(const std::string& key, uint32_t m) {
+    uint8_t digest[20];
+    Sha1Digest(key, digest);
+    ChordId id = 0;
+    for (uint32_t i = 20 - CHORD_ID_BITS / 8; i < 20; i++) {
+        id = (id << 8) | ChordId(digest[i]);
+    }
+    return IdMask(id, m);
+}
 
-        storedFiles.insert(msg.targetId);
-        cout << "DEBUG: Node " << chordId << " ha memorizzato il file " << msg.targetId << endl;
-        
-        cout << "DEBUG: Node " << chordId << " ora ha " << storedFiles.size() << " file memorizzati: ";
-        for (const uint32_t fileId : storedFiles) {
-            cout << fileId << " ";
-        }
-        cout << endl;
+// Struttura per i messaggi Chord
+struct ChordMessage {
+    enum MessageType {
+        LOOKUP_REQUEST,
+        LOOKUP_RESPONSE,
+        STORE_FILE,
+        STORE_ACK,
+        LOOKUP_ACK,         // conferma hop-by-hop della ricezione di una LOOKUP_REQUEST
+        // Manutenzione dell'anello
+        STABILIZE,              // richiesta al successore del suo predecessore e della sua successor list
+        STABILIZE_REPLY,
+        NOTIFY,                 // il mittente si propone come predecessore del destinatario
+        FIND_SUCCESSOR,         // instradata come un lookup, usata da fix_fingers
+        FIND_SUCCESSOR_REPLY,   // inviata direttamente all'origine con il successore in successorId
+        PING,                   // check_predecessor
+        PONG,
+        // Ingresso di un nuovo nodo
+        JOIN,                   // inviata dal nuovo nodo al suo successore
+        JOIN_REPLY,             // predecessore e successor list del successore, oppure rifiuto
+        KEY_TRANSFER,           // chiavi cedute al nuovo nodo dal suo successore
+        // Lookup iterativo e semi-ricorsivo
+        FIND_NEXT_HOP,          // l'origine chiede a un nodo l'esito del lookup o i nodi a cui proseguire
+        NEXT_HOP_REPLY,         // esito in success oppure candidati in successors (OPT_OWNER: ritenuti responsabili)
+        LOOKUP_PROGRESS         // un hop intermedio notifica all'origine di aver ricevuto la richiesta
+    };
+    static const uint32_t TYPE_COUNT = LOOKUP_PROGRESS + 1;
 
-        ChordMessage ack;
-        ack.type = ChordMessage::STORE_ACK;
-        ack.senderId = chordId;
-        ack.originId = msg.senderId;
-        ack.targetId = msg.targetId;
-        ack.success = true;
-        ack.hopCount = 0;
-        Ptr<Packet> packet = Create<Packet>((uint8_t*)&ack, sizeof(ChordMessage));
-        SendMessage(packet, from);
+    // Campi opzionali: vengono serializzati solo se il relativo bit è presente in options.
+    // OPT_OWNER è un semplice flag senza campo associato
+    enum Option {
+        OPT_NONCE = 0x01,           // identificatore del lookup
+        OPT_REPLICA_HINT = 0x02,    // indice della replica a cui è destinato il messaggio
+        OPT_SUCCESSOR = 0x04,       // successore del mittente in piggyback
+        OPT_OWNER = 0x08,           // il destinatario è ritenuto responsabile della chiave
+        OPT_PREDECESSOR = 0x10,     // predecessore del mittente
+        OPT_SUCCESSOR_LIST = 0x20,  // successor list del mittente
+        OPT_KEY_LIST = 0x40         // chiavi trasferite
+    };
+    
+    MessageType type;
+    ChordId senderId;       // ID del nodo che invia il messaggio
+    ChordId originId;       // ID del nodo che ha avviato il lookup (per inviare la risposta direttamente)
+    ChordId targetId;       // chordId del file o del nodo target
+    uint32_t hopCount;
+    bool success;
+    uint8_t options;
+    uint32_t nonce;
+    uint8_t replicaHint;
+    ChordId successorId;
+    ChordId predecessorId;
+    std::vector<ChordId> successors;
+    std::vector<ChordId> keys;
+
+    ChordMessage() : type(LOOKUP_REQUEST), senderId(0), originId(0), targetId(0), hopCount(0),
+                     success(false), options(0), nonce(0), replicaHint(0), successorId(0), predecessorId(0) {}
+
+    bool HasOption(Option option) const {
+        return (options & option) != 0;
+    }
+};
+
+std::string GetMessageTypeName(ChordMessage::MessageType type) {
+    switch (type) {
+        case ChordMessage::LOOKUP_REQUEST: return "LOOKUP_REQUEST";
+        case ChordMessage::LOOKUP_RESPONSE: return "LOOKUP_RESPONSE";
+        case ChordMessage::STORE_FILE: return "STORE_FILE";
+        case ChordMessage::STORE_ACK: return "STORE_ACK";
+        case ChordMessage::LOOKUP_ACK: return "LOOKUP_ACK";
+        case ChordMessage::STABILIZE: return "STABILIZE";
+        case ChordMessage::STABILIZE_REPLY: return "STABILIZE_REPLY";
+        case ChordMessage::NOTIFY: return "NOTIFY";
+        case ChordMessage::FIND_SUCCESSOR: return "FIND_SUCCESSOR";
+        case ChordMessage::FIND_SUCCESSOR_REPLY: return "FIND_SUCCESSOR_REPLY";
+        case ChordMessage::PING: return "PING";
+        case ChordMessage::PONG: return "PONG";
+        case ChordMessage::JOIN: return "JOIN";
+        case ChordMessage::JOIN_REPLY: return "JOIN_REPLY";
+        case ChordMessage::KEY_TRANSFER: return "KEY_TRANSFER";
+        case ChordMessage::FIND_NEXT_HOP: return "FIND_NEXT_HOP";
+        case ChordMessage::NEXT_HOP_REPLY: return "NEXT_HOP_REPLY";
+        case ChordMessage::LOOKUP_PROGRESS: return "LOOKUP_PROGRESS";
+        default: return "UNKNOWN";
     }
+}
 
-    void HandleLookupTimeout(uint32_t fileId, uint32_t lookupId) {
-        cout << "ChordApplication::HandleLookupTimeout - Node " << chordId << " fileId: " << fileId << " lookupId: " << lookupId << endl;
-        cout << "La ricerca " << lookupId << " del nodo " << chordId << " per il file " << fileId << " ha timeoutato" << endl;
-        pendingLookups.erase(fileId);
-        
-        if (!statsCallback.IsNull()) {
-            statsCallback(false, 0, lookupId);
+// Header ns-3 per ChordMessage con formato compatto e indipendente dall'architettura:
+//   type (1 byte) | flags (1 byte) | senderId, originId, targetId, hopCount (varint)
+//   [nonce (4 byte)] [replicaHint (1 byte)] [successorId (varint)] [predecessorId (varint)]
+//   [numero di successori (1 byte) | successori (varint)] [numero di chiavi (2 byte) | chiavi (varint)]
+// I bit bassi di flags contengono le opzioni presenti, il bit alto l'esito (success);
+// OPT_OWNER non ha un campo associato. Gli identificatori sono varint di qualunque larghezza
+// (fino a CHORD_ID_BITS / 7 + 1 byte), quindi con m piccolo restano compatti anche a 160 bit
+class ChordHeader : public Header {
+private:
+    static const uint8_t SUCCESS_FLAG = 0x80;
+
+    ChordMessage msg;
+
+    template <typename T>
+    static uint32_t GetVarintSize(T value) {
+        uint32_t size = 1;
+        while (value >= T(0x80)) {
+            value = value >> 7;
+            size++;
         }
+        return size;
     }
 
-    bool IsInRange(uint32_t id, uint32_t start, uint32_t end) {
-        if (start < end) {
-            return id > start && id <= end;
-        } else {
-            return id > start || id <= end;
+    template <typename T>
+    static void WriteVarint(Buffer::Iterator& it, T value) {
+        while (value >= T(0x80)) {
+            it.WriteU8((uint8_t)(IdLow64(value) | 0x80));
+            value = value >> 7;
         }
+        it.WriteU8((uint8_t)IdLow64(value));
     }
 
-    std::string GetMessageTypeName(ChordMessage::MessageType type) {
-        switch (type) {
-            case ChordMessage::LOOKUP_REQUEST: return "LOOKUP_REQUEST";
-            case ChordMessage::LOOKUP_RESPONSE: return "LOOKUP_RESPONSE";
-            case ChordMessage::STORE_FILE: return "STORE_FILE";
-            case ChordMessage::STORE_ACK: return "STORE_ACK";
-            default: return "UNKNOWN";
+    template <typename T>
+    static T ReadVarint(Buffer::Iterator& it) {
+        T value = 0;
+        for (uint32_t shift = 0; shift < sizeof(T) * 8; shift += 7) {
+            uint8_t byte = it.ReadU8();
+            value = value | (T(byte & 0x7f) << shift);
+            if (!(byte & 0x80)) {
+                break;
+            }
         }
+        return value;
     }
-};
 
-uint32_t ChordApplication::nextLookupId = 0;
+public:
+    // Dimensione minima: type, flags e quattro varint da un byte
+    static const uint32_t MIN_SIZE = 6;
 
-class ChordNetwork {
-private:
-    uint32_t m;                      
-    uint32_t numNodes;               
-    uint32_t numFiles;               
-    uint32_t numLookups;          
-    uint32_t failingNodes;           
-    Time timeoutDuration;            
-    
-    std::vector<uint32_t> files;
-    std::vector<uint32_t> filesForLookup;  
-    std::vector<ChordNode> nodes;    
-    NodeContainer nsNodes;           
-    std::vector<Ptr<ChordApplication>> applications;  
-    
-    struct Statistics {
-        uint32_t totalLookups;
-        uint32_t successfulLookups;
-        uint32_t averageHops;
-        uint32_t failedLookups;
-        uint32_t minHops;
-        uint32_t maxHops;
+    static TypeId GetTypeId(void) {
+        static TypeId tid = TypeId("ChordHeader")
+            .SetParent<Header>()
+            .AddConstructor<ChordHeader>();
+        return tid;
+    }
 
-        Statistics() : totalLookups(0), successfulLookups(0), averageHops(0), failedLookups(0), 
-                       minHops(UINT32_MAX), maxHops(0) {}
-    } stats;
+    ChordHeader() {}
 
-    std::set<uint32_t> processedLookups;
+    explicit ChordHeader(const ChordMessage& message) : msg(message) {}
+
+    const ChordMessage& GetMessage() const {
+        return msg;
+    }
+
+    TypeId GetInstanceTypeId(void) const override {
+        return GetTypeId();
+    }
+
+    uint32_t GetSerializedSize(void) const override {
+        uint32_t size = 2 + GetVarintSize(msg.senderId) + GetVarintSize(msg.originId)
+                          + GetVarintSize(msg.targetId) + GetVarintSize(msg.hopCount);
+        if (msg.HasOption(ChordMessage::OPT_NONCE)) {
+            size += 4;
+        }
+        if (msg.HasOption(ChordMessage::OPT_REPLICA_HINT)) {
+            size += 1;
+        }
+        if (msg.HasOption(ChordMessage::OPT_SUCCESSOR)) {
+            size += GetVarintSize(msg.successorId);
+        }
+        if (msg.HasOption(ChordMessage::OPT_PREDECESSOR)) {
+            size += GetVarintSize(msg.predecessorId);
+        }
+        if (msg.HasOption(ChordMessage::OPT_SUCCESSOR_LIST)) {
+            size += 1;
+            for (size_t i = 0; i < std::min(msg.successors.size(), (size_t)255); i++) {
+                size += GetVarintSize(msg.successors[i]);
+            }
+        }
+        if (msg.HasOption(ChordMessage::OPT_KEY_LIST)) {
+            size += 2;
+            for (size_t i = 0; i < std::min(msg.keys.size(), (size_t)UINT16_MAX); i++) {
+                size += GetVarintSize(msg.keys[i]);
+            }
+        }
+        return size;
+    }
+
+    void Serialize(Buffer::Iterator start) const override {
+        Buffer::Iterator it = start;
+        it.WriteU8((uint8_t)msg.type);
+        it.WriteU8((msg.options & ~SUCCESS_FLAG) | (msg.success ? SUCCESS_FLAG : 0));
+        WriteVarint(it, msg.senderId);
+        WriteVarint(it, msg.originId);
+        WriteVarint(it, msg.targetId);
+        WriteVarint(it, msg.hopCount);
+        if (msg.HasOption(ChordMessage::OPT_NONCE)) {
+            it.WriteHtonU32(msg.nonce);
+        }
+        if (msg.HasOption(ChordMessage::OPT_REPLICA_HINT)) {
+            it.WriteU8(msg.replicaHint);
+        }
+        if (msg.HasOption(ChordMessage::OPT_SUCCESSOR)) {
+            WriteVarint(it, msg.successorId);
+        }
+        if (msg.HasOption(ChordMessage::OPT_PREDECESSOR)) {
+            WriteVarint(it, msg.predecessorId);
+        }
+        if (msg.HasOption(ChordMessage::OPT_SUCCESSOR_LIST)) {
+            uint8_t count = (uint8_t)std::min(msg.successors.size(), (size_t)255);
+            it.WriteU8(count);
+            for (uint8_t i = 0; i < count; i++) {
+                WriteVarint(it, msg.successors[i]);
+            }
+        }
+        if (msg.HasOption(ChordMessage::OPT_KEY_LIST)) {
+            uint16_t count = (uint16_t)std::min(msg.keys.size(), (size_t)UINT16_MAX);
+            it.WriteHtonU16(count);
+            for (uint16_t i = 0; i < count; i++) {
+                WriteVarint(it, msg.keys[i]);
+            }
+        }
+    }
+
+    uint32_t Deserialize(Buffer::Iterator start) override {
+        Buffer::Iterator it = start;
+        msg = ChordMessage();
+        msg.type = (ChordMessage::MessageType)it.ReadU8();
+        uint8_t flags = it.ReadU8();
+        msg.success = (flags & SUCCESS_FLAG) != 0;
+        msg.options = flags & ~SUCCESS_FLAG;
+        msg.senderId = ReadVarint<ChordId>(it);
+        msg.originId = ReadVarint<ChordId>(it);
+        msg.targetId = ReadVarint<ChordId>(it);
+        msg.hopCount = ReadVarint<uint32_t>(it);
+        if (msg.HasOption(ChordMessage::OPT_NONCE)) {
+            msg.nonce = it.ReadNtohU32();
+        }
+        if (msg.HasOption(ChordMessage::OPT_REPLICA_HINT)) {
+            msg.replicaHint = it.ReadU8();
+        }
+        if (msg.HasOption(ChordMessage::OPT_SUCCESSOR)) {
+            msg.successorId = ReadVarint<ChordId>(it);
+        }
+        if (msg.HasOption(ChordMessage::OPT_PREDECESSOR)) {
+            msg.predecessorId = ReadVarint<ChordId>(it);
+        }
+        if (msg.HasOption(ChordMessage::OPT_SUCCESSOR_LIST)) {
+            uint8_t count = it.ReadU8();
+            msg.successors.resize(count);
+            for (uint8_t i = 0; i < count; i++) {
+                msg.successors[i] = ReadVarint<ChordId>(it);
+            }
+        }
+        if (msg.HasOption(ChordMessage::OPT_KEY_LIST)) {
+            uint16_t count = it.ReadNtohU16();
+            msg.keys.resize(count);
+            for (uint16_t i = 0; i < count; i++) {
+                msg.keys[i] = ReadVarint<ChordId>(it);
+            }
+        }
+        return it.GetDistanceFrom(start);
+    }
+
+    void Print(std::ostream& os) const override {
+        os << GetMessageTypeName(msg.type)
+           << " sender=" << msg.senderId
+           << " origin=" << msg.originId
+           << " target=" << msg.targetId
+           << " hops=" << msg.hopCount
+           << " success=" << msg.success;
+        if (msg.HasOption(ChordMessage::OPT_NONCE)) {
+            os << " nonce=" << msg.nonce;
+        }
+        if (msg.HasOption(ChordMessage::OPT_REPLICA_HINT)) {
+            os << " replica=" << (uint32_t)msg.replicaHint;
+        }
+        if (msg.HasOption(ChordMessage::OPT_SUCCESSOR)) {
+            os << " successor=" << msg.successorId;
+        }
+        if (msg.HasOption(ChordMessage::OPT_OWNER)) {
+            os << " owner";
+        }
+        if (msg.HasOption(ChordMessage::OPT_PREDECESSOR)) {
+            os << " predecessor=" << msg.predecessorId;
+        }
+        if (msg.HasOption(ChordMessage::OPT_SUCCESSOR_LIST)) {
+            os << " successors=" << msg.successors.size();
+        }
+        if (msg.HasOption(ChordMessage::OPT_KEY_LIST)) {
+            os << " keys=" << msg.keys.size();
+        }
+    }
+};
+
+// Crea un pacchetto contenente solo l'header Chord del messaggio
+Ptr<Packet> CreateMessagePacket(const ChordMessage& msg) {
+    Ptr<Packet> packet = Create<Packet>();
+    packet->AddHeader(ChordHeader(msg));
+    return packet;
+}
+
+// Struttura per i nodi Chord
+struct ChordNode {
+    ChordId chordId;
+    std::vector<ChordId> fingerTable;
+    std::vector<ChordId> successorList;
+    ChordId predecessor;
+    std::set<ChordId> storedFiles;
+    bool isAlive;
+    bool failed;          // guasto permanente: il churn non lo fa rientrare
+    Ptr<Node> nsNode;     // Riferimento al nodo fisico
+    std::map<ChordId, double> neighborRtt;   // RTT nell'underlay verso i vicini (solo con PNS/PRS)
+
+    ChordNode(ChordId id, Ptr<Node> node) : chordId(id), predecessor(0), isAlive(true), failed(false), nsNode(node) {}
+};
+
+// Indice ordinato dei chordId dei nodi attivi: costruito una volta, interrogato con ricerca binaria
+// e aggiornato in modo incrementale quando un nodo entra o esce dall'anello
+class ChordRing {
+private:
+    std::vector<ChordId> sortedIds;
 
 public:
-    ChordNetwork(uint32_t m_param = 10, 
-                uint32_t nodes_param = 100,
-                uint32_t files_param = 50,
-                uint32_t lookups_param = 25,  
-                uint32_t failing_param = 10,
-                Time timeout = Seconds(5.0))
-        : m(m_param)
-        , numNodes(nodes_param)
-        , numFiles(files_param)
-        , numLookups(lookups_param)
-        , failingNodes(failing_param)
-        , timeoutDuration(timeout) {
-            initializeNetwork();
+    void Build(const std::vector<ChordId>& ids) {
+        sortedIds = ids;
+        std::sort(sortedIds.begin(), sortedIds.end());
+        sortedIds.erase(std::unique(sortedIds.begin(), sortedIds.end()), sortedIds.end());
+    }
+
+    void Insert(ChordId id) {
+        auto it = std::lower_bound(sortedIds.begin(), sortedIds.end(), id);
+        if (it == sortedIds.end() || *it != id) {
+            sortedIds.insert(it, id);
+        }
+    }
+
+    void Remove(ChordId id) {
+        auto it = std::lower_bound(sortedIds.begin(), sortedIds.end(), id);
+        if (it != sortedIds.end() && *it == id) {
+            sortedIds.erase(it);
+        }
+    }
+
+    bool Contains(ChordId id) const {
+        return std::binary_search(sortedIds.begin(), sortedIds.end(), id);
+    }
+
+    bool Empty() const {
+        return sortedIds.empty();
+    }
+
+    size_t Size() const {
+        return sortedIds.size();
+    }
+
+    // i-esimo nodo attivo in ordine di chordId
+    ChordId At(size_t i) const {
+        return sortedIds[i];
+    }
+
+    // Primo nodo con chordId >= id (con wrap-around sull'anello)
+    ChordId Successor(ChordId id) const {
+        NS_ASSERT(!sortedIds.empty());
+        auto it = std::lower_bound(sortedIds.begin(), sortedIds.end(), id);
+        return it == sortedIds.end() ? sortedIds.front() : *it;
+    }
+
+    // Ultimo nodo con chordId < id (con wrap-around sull'anello)
+    ChordId Predecessor(ChordId id) const {
+        NS_ASSERT(!sortedIds.empty());
+        auto it = std::lower_bound(sortedIds.begin(), sortedIds.end(), id);
+        return it == sortedIds.begin() ? sortedIds.back() : *(it - 1);
+    }
+
+    // I k nodi che seguono id sull'anello, escluso id stesso
+    std::vector<ChordId> Successors(ChordId id, uint32_t k) const {
+        std::vector<ChordId> result;
+        if (sortedIds.empty()) {
+            return result;
+        }
+        size_t pos = std::upper_bound(sortedIds.begin(), sortedIds.end(), id) - sortedIds.begin();
+        for (size_t i = 0; i < sortedIds.size() && result.size() < k; i++) {
+            ChordId candidate = sortedIds[(pos + i) % sortedIds.size()];
+            if (candidate == id) {
+                break;
+            }
+            result.push_back(candidate);
+        }
+        return result;
+    }
+};
+
+// Directory condivisa chordId -> indirizzo, in sola lettura durante la simulazione.
+// Un'unica istanza è referenziata da tutte le ChordApplication: ogni nodo tiene in locale
+// solo gli indirizzi dei vicini che conosce (finger, successori, predecessore)
+class ChordAddressDirectory : public SimpleRefCount<ChordAddressDirectory> {
+private:
+    std::vector<std::pair<ChordId, Address>> entries;   // ordinato per chordId
+
+public:
+    void Build(std::vector<std::pair<ChordId, Address>> all) {
+        entries = std::move(all);
+        std::sort(entries.begin(), entries.end(),
+            [](const std::pair<ChordId, Address>& a, const std::pair<ChordId, Address>& b) { return a.first < b.first; });
+    }
+
+    void Add(ChordId chordId, const Address& address) {
+        auto it = std::lower_bound(entries.begin(), entries.end(), chordId,
+            [](const std::pair<ChordId, Address>& e, ChordId id) { return e.first < id; });
+        if (it != entries.end() && it->first == chordId) {
+            it->second = address;
+        } else {
+            entries.insert(it, std::make_pair(chordId, address));
+        }
+    }
+
+    bool Lookup(ChordId chordId, Address& address) const {
+        auto it = std::lower_bound(entries.begin(), entries.end(), chordId,
+            [](const std::pair<ChordId, Address>& e, ChordId id) { return e.first < id; });
+        if (it == entries.end() || it->first != chordId) {
+            return false;
+        }
+        address = it->second;
+        return true;
+    }
+
+    size_t Size() const {
+        return entries.size();
+    }
+};
+
+// Tabella hash a indirizzamento aperto (linear probing) per le lookup in corso, indicizzata dal nonce.
+// Inserimento, ricerca e cancellazione sono O(1) anche con molte lookup concorrenti per nodo;
+// la cancellazione usa il backward shift, quindi non restano tombstone
+template <typename Value>
+class PendingLookupTable {
+private:
+    struct Slot {
+        uint32_t key;
+        bool used;
+        Value value;
+
+        Slot() : key(0), used(false), value() {}
+    };
+
+    std::vector<Slot> slots;   // la dimensione è sempre una potenza di due
+    size_t count;
+
+    size_t IndexOf(uint32_t key) const {
+        // Hashing di Fibonacci: i nonce sono sequenziali, la moltiplicazione li disperde
+        return (size_t)((key * 2654435769u) & (slots.size() - 1));
+    }
+
+    void Grow() {
+        std::vector<Slot> old;
+        old.swap(slots);
+        slots.resize(old.size() * 2);
+        count = 0;
+        for (Slot& slot : old) {
+            if (slot.used) {
+                Insert(slot.key) = slot.value;
+            }
+        }
+    }
+
+public:
+    PendingLookupTable() : slots(16), count(0) {}
+
+    // Restituisce il valore associato a key, creandolo se non esiste
+    Value& Insert(uint32_t key) {
+        if ((count + 1) * 2 > slots.size()) {
+            Grow();
+        }
+        size_t mask = slots.size() - 1;
+        size_t i = IndexOf(key);
+        while (slots[i].used && slots[i].key != key) {
+            i = (i + 1) & mask;
+        }
+        if (!slots[i].used) {
+            slots[i].used = true;
+            slots[i].key = key;
+            slots[i].value = Value();
+            count++;
+        }
+        return slots[i].value;
+    }
+
+    Value* Find(uint32_t key) {
+        size_t mask = slots.size() - 1;
+        for (size_t i = IndexOf(key); slots[i].used; i = (i + 1) & mask) {
+            if (slots[i].key == key) {
+                return &slots[i].value;
+            }
+        }
+        return nullptr;
+    }
+
+    bool Erase(uint32_t key) {
+        size_t mask = slots.size() - 1;
+        size_t i = IndexOf(key);
+        while (slots[i].used && slots[i].key != key) {
+            i = (i + 1) & mask;
+        }
+        if (!slots[i].used) {
+            return false;
+        }
+        // Backward shift: sposta indietro gli elementi successivi che non sono nella loro posizione ideale
+        size_t hole = i;
+        for (size_t j = (i + 1) & mask; slots[j].used; j = (j + 1) & mask) {
+            size_t ideal = IndexOf(slots[j].key);
+            if (((j - ideal) & mask) >= ((j - hole) & mask)) {
+                slots[hole] = slots[j];
+                hole = j;
+            }
+        }
+        slots[hole] = Slot();
+        count--;
+        return true;
+    }
+
+    size_t Size() const {
+        return count;
+    }
+};
+
+// Cache LRU delle posizioni delle chiavi (chiave -> nodo che ha risposto al lookup) con scadenza:
+// quando è piena viene scartata la voce usata meno di recente, le voci scadute alla prima consultazione
+class LocationCache {
+private:
+    struct Entry {
+        ChordId key;
+        ChordId nodeId;
+        Time expires;
+    };
+
+    std::list<Entry> entries;   // dalla più recente alla meno recente
+    std::unordered_map<ChordId, std::list<Entry>::iterator> index;
+    size_t capacity;
+    Time ttl;
+
+public:
+    LocationCache() : capacity(0) {}
+
+    void Configure(size_t size, Time timeToLive) {
+        capacity = size;
+        ttl = timeToLive;
+        Clear();
+    }
+
+    bool Enabled() const {
+        return capacity > 0;
+    }
+
+    void Insert(ChordId key, ChordId nodeId) {
+        if (capacity == 0) {
+            return;
+        }
+        Erase(key);
+        if (entries.size() >= capacity) {
+            index.erase(entries.back().key);
+            entries.pop_back();
+        }
+        entries.push_front({key, nodeId, Simulator::Now() + ttl});
+        index[key] = entries.begin();
+    }
+
+    bool Lookup(ChordId key, ChordId& nodeId) {
+        auto it = index.find(key);
+        if (it == index.end()) {
+            return false;
+        }
+        if (it->second->expires <= Simulator::Now()) {
+            entries.erase(it->second);
+            index.erase(it);
+            return false;
+        }
+        entries.splice(entries.begin(), entries, it->second);
+        nodeId = it->second->nodeId;
+        return true;
+    }
+
+    void Erase(ChordId key) {
+        auto it = index.find(key);
+        if (it != index.end()) {
+            entries.erase(it->second);
+            index.erase(it);
+        }
+    }
+
+    // Invalida tutte le voci che puntano a un nodo ritenuto guasto
+    void EraseNode(ChordId nodeId) {
+        for (auto it = entries.begin(); it != entries.end();) {
+            if (it->nodeId == nodeId) {
+                index.erase(it->key);
+                it = entries.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    void Clear() {
+        entries.clear();
+        index.clear();
+    }
+
+    size_t Size() const {
+        return entries.size();
+    }
+};
+
+// Istogramma di latenze a memoria costante in stile HDR: i valori (in microsecondi) sotto
+// 2^PRECISION_BITS sono esatti, quelli più grandi finiscono in bucket log-lineari con errore
+// relativo inferiore a 2^-PRECISION_BITS (< 1%). Copre fino a 2^MAX_BITS us (~12 giorni)
+class LatencyHistogram {
+private:
+    static const uint32_t PRECISION_BITS = 7;
+    static const uint32_t SUB_BUCKETS = 1u << PRECISION_BITS;
+    static const uint32_t MAX_BITS = 40;
+
+    std::vector<uint64_t> counts;
+    uint64_t total;
+    uint64_t sum;
+    uint64_t minValue;
+    uint64_t maxValue;
+
+    static uint32_t BucketOf(uint64_t value) {
+        if (value < SUB_BUCKETS) {
+            return (uint32_t)value;
+        }
+        uint32_t msb = 63 - __builtin_clzll(value);
+        uint32_t shift = msb - PRECISION_BITS;
+        return (shift + 1) * SUB_BUCKETS + (uint32_t)((value >> shift) - SUB_BUCKETS);
+    }
+
+    static uint64_t BucketLow(uint32_t bucket) {
+        if (bucket < SUB_BUCKETS) {
+            return bucket;
+        }
+        uint32_t shift = bucket / SUB_BUCKETS - 1;
+        return (uint64_t)(bucket % SUB_BUCKETS + SUB_BUCKETS) << shift;
+    }
+
+    static uint64_t BucketHigh(uint32_t bucket) {
+        if (bucket < SUB_BUCKETS) {
+            return bucket;
+        }
+        uint32_t shift = bucket / SUB_BUCKETS - 1;
+        return BucketLow(bucket) + ((uint64_t)1 << shift) - 1;
+    }
+
+public:
+    LatencyHistogram()
+        : counts((MAX_BITS - PRECISION_BITS + 1) * SUB_BUCKETS, 0), total(0), sum(0),
+          minValue(UINT64_MAX), maxValue(0) {}
+
+    void Record(Time latency) {
+        int64_t us = latency.GetMicroSeconds();
+        uint64_t value = us < 0 ? 0 : std::min((uint64_t)us, ((uint64_t)1 << MAX_BITS) - 1);
+        counts[BucketOf(value)]++;
+        total++;
+        sum += value;
+        minValue = std::min(minValue, value);
+        maxValue = std::max(maxValue, value);
+    }
+
+    void Reset() {
+        std::fill(counts.begin(), counts.end(), 0);
+        total = 0;
+        sum = 0;
+        minValue = UINT64_MAX;
+        maxValue = 0;
+    }
+
+    void Merge(const LatencyHistogram& other) {
+        for (size_t i = 0; i < counts.size(); i++) {
+            counts[i] += other.counts[i];
+        }
+        total += other.total;
+        sum += other.sum;
+        minValue = std::min(minValue, other.minValue);
+        maxValue = std::max(maxValue, other.maxValue);
+    }
+
+#ifdef NS3_MPI
+    // Somma gli istogrammi di tutti i rank di una simulazione distribuita
+    void AllReduce(MPI_Comm comm) {
+        MPI_Allreduce(MPI_IN_PLACE, counts.data(), counts.size(), MPI_UINT64_T, MPI_SUM, comm);
+        MPI_Allreduce(MPI_IN_PLACE, &total, 1, MPI_UINT64_T, MPI_SUM, comm);
+        MPI_Allreduce(MPI_IN_PLACE, &sum, 1, MPI_UINT64_T, MPI_SUM, comm);
+        MPI_Allreduce(MPI_IN_PLACE, &minValue, 1, MPI_UINT64_T, MPI_MIN, comm);
+        MPI_Allreduce(MPI_IN_PLACE, &maxValue, 1, MPI_UINT64_T, MPI_MAX, comm);
+    }
+#endif
+
+    uint64_t Count() const {
+        return total;
+    }
+
+    double MeanMs() const {
+        return total > 0 ? (double)sum / total / 1000.0 : 0.0;
+    }
+
+    double MinMs() const {
+        return total > 0 ? minValue / 1000.0 : 0.0;
+    }
+
+    double MaxMs() const {
+        return maxValue / 1000.0;
+    }
+
+    // Percentile q in [0, 1], restituito in millisecondi (limite superiore del bucket)
+    double PercentileMs(double q) const {
+        if (total == 0) {
+            return 0.0;
+        }
+        uint64_t rank = std::max<uint64_t>(1, (uint64_t)std::ceil(q * total));
+        uint64_t seen = 0;
+        for (uint32_t i = 0; i < counts.size(); i++) {
+            seen += counts[i];
+            if (seen >= rank) {
+                return std::min(BucketHigh(i), maxValue) / 1000.0;
+            }
+        }
+        return MaxMs();
+    }
+
+    // Bucket non vuoti come array JSON di [min_us, max_us, conteggio]
+    void WriteJson(std::ostream& os) const {
+        os << "{\"count\": " << total
+           << ", \"mean_ms\": " << MeanMs()
+           << ", \"min_ms\": " << MinMs()
+           << ", \"max_ms\": " << MaxMs()
+           << ", \"buckets\": [";
+        bool first = true;
+        for (uint32_t i = 0; i < counts.size(); i++) {
+            if (counts[i] == 0) {
+                continue;
+            }
+            os << (first ? "" : ", ") << "[" << BucketLow(i) << ", " << BucketHigh(i) << ", " << counts[i] << "]";
+            first = false;
+        }
+        os << "]}";
+    }
+};
+
+// Formatta una lista di ID per i messaggi di log; viene valutata solo se il livello di log è attivo
+template <typename Container>
+std::string FormatIds(const Container& ids) {
+    std::ostringstream os;
+    for (const auto& id : ids) {
+        os << id << " ";
+    }
+    return os.str();
+}
+
+// Contatori di un nodo per un tipo di messaggio; i byte sono a livello IP
+struct MessageCounters {
+    uint64_t sentPackets;
+    uint64_t sentBytes;
+    uint64_t receivedPackets;
+    uint64_t receivedBytes;
+    uint64_t forwarded;     // richieste inoltrate per conto di un altro nodo
+    uint64_t timeouts;      // richieste di questo tipo rimaste senza risposta
+    uint64_t dropped;       // messaggi non inviati perché il nodo è spento
+
+    MessageCounters() : sentPackets(0), sentBytes(0), receivedPackets(0), receivedBytes(0),
+                        forwarded(0), timeouts(0), dropped(0) {}
+
+    void Add(const MessageCounters& other) {
+        sentPackets += other.sentPackets;
+        sentBytes += other.sentBytes;
+        receivedPackets += other.receivedPackets;
+        receivedBytes += other.receivedBytes;
+        forwarded += other.forwarded;
+        timeouts += other.timeouts;
+        dropped += other.dropped;
+    }
+};
+
+// Parametri della simulazione, impostati da riga di comando in main
+struct ChordConfig {
+    uint32_t m;
+    uint32_t numNodes;
+    uint32_t numFiles;
+    uint32_t numLookups;
+    uint32_t failingNodes;
+    Time timeout;
+
+    // Chiavi dei file: il loro ID è lo SHA-1 del nome modulo 2^m. keyNames contiene i nomi letti
+    // da keysFile, uno per riga; senza keysFile i file si chiamano file-0, file-1, ...
+    std::string keysFile;
+    std::vector<std::string> keyNames;
+
+    // Routing: lunghezza della successor list e timeout iniziale per la conferma di ogni hop
+    // (0 = nessuna conferma, i nodi guasti vengono scoperti solo dal timeout del lookup)
+    uint32_t successorListSize;
+    double hopTimeout;
+
+    // Copie di ogni chiave: il responsabile più i primi replicas-1 successori
+    uint32_t replicas;
+
+    // Modalità di lookup: "recursive" (ogni hop inoltra la richiesta), "iterative" (l'origine
+    // interroga i nodi uno per uno con FIND_NEXT_HOP, alpha richieste in parallelo) o "semi"
+    // (ricorsiva con notifiche di avanzamento; se la richiesta si blocca l'origine prosegue iterativa)
+    std::string lookupMode;
+    uint32_t alpha;
+
+    // Proximity neighbour selection: ogni finger è il nodo con RTT minore tra i primi pnsCandidates
+    // del suo intervallo (1 = successore esatto di n + 2^i); proximity route selection: il prossimo
+    // hop bilancia l'avanzamento nello spazio degli ID e l'RTT verso il vicino
+    uint32_t pnsCandidates;
+    bool prs;
+
+    // Cache delle posizioni delle chiavi per nodo (0 = disattivata) e durata delle voci in secondi
+    uint32_t cacheSize;
+    double cacheTtl;
+
+    // Periodi in secondi dei protocolli di manutenzione (0 = disattivato, tabelle statiche)
+    double stabilizePeriod;
+    double fixFingersPeriod;
+    double checkPredecessorPeriod;
+
+    // Nodi che entrano nell'anello durante la simulazione, a ondate di joinWave nodi
+    // ogni joinInterval secondi a partire da joinStart
+    uint32_t joiningNodes;
+    double joinStart;
+    uint32_t joinWave;
+    double joinInterval;
+
+    // Churn continuo: ogni nodo alterna sessioni attive e periodi di assenza con durate
+    // estratte da churn ("none", "exp", "pareto", "weibull"); churnShape è il parametro di forma
+    // di Pareto e Weibull, le medie sono in secondi
+    std::string churn;
+    double sessionTime;
+    double downTime;
+    double churnShape;
+    double churnStart;
+
+    // Serie temporale di successo e latenza dei lookup (vuoto = disattivata)
+    std::string timeSeriesFile;
+    double timeSeriesInterval;
+
+    // Contatori per nodo e per tipo di messaggio, scritti a fine simulazione (vuoto = disattivati)
+    // e ogni nodeStatsInterval secondi se positivo
+    std::string nodeStatsFile;
+    double nodeStatsInterval;
+
+    // Motore di simulazione: "packet" simula ogni messaggio con UDP/IP e point-to-point, "analytic"
+    // fa avanzare i lookup come eventi pianificati con i ritardi di analyticDelay ("underlay": modello
+    // dell'underlay precalcolato, "hops": hopLatency secondi per hop), senza nodi ns-3 né socket
+    std::string engine;
+    std::string analyticDelay;
+    double hopLatency;
+
+    // Simulazione distribuita con MPI: ogni rank costruisce l'intera topologia ma esegue solo le
+    // applicazioni dei nodi che gli assegna il partizionatore ("block": intervalli contigui di indici,
+    // che con il generatore dell'underlay tagliano pochi collegamenti; "roundrobin": indice modulo rank)
+    bool mpi;
+    std::string partition;
+
+    // Underlay: "default" (anello di 10 nodi più 3 collegamenti verso una finestra di nodi precedenti),
+    // "transit-stub", "ba" (Barabási–Albert con baLinks collegamenti per nodo), "lan" (segmenti CSMA
+    // di domainSize nodi con i router collegati per preferential attachment) o "file" (topologyFile).
+    // linkDelay e linkRate sono ritardo e banda di base dei collegamenti
+    std::string topology;
+    std::string topologyFile;
+    double linkDelay;
+    std::string linkRate;
+    uint32_t baLinks;
+    uint32_t domainSize;
+    uint32_t transitNodes;       // nodi del nucleo transit-stub (0 = uno ogni 4 domini stub)
+
+    // Istantanea dell'anello costruito: saveRing la scrive dopo la costruzione, loadRing la usa al
+    // posto di generazione di ID, underlay, tabelle di routing e inserimento dei file
+    std::string saveRing;
+    std::string loadRing;
+
+    // Workload: "fixed" riproduce la sequenza storica di lookup a 0.1s l'uno dall'altro,
+    // "constant", "poisson" e "bursty" generano arrivi open-loop al tasso aggregato rate
+    std::string arrival;
+    double rate;            // lookup al secondo su tutta la rete
+    double warmup;          // secondi iniziali di lookup non conteggiati nelle statistiche
+    double duration;        // finestra di misura in secondi (0 = fino a numLookups lookup misurati)
+    double burstOn;         // durata delle fasi attive del traffico bursty
+    double burstOff;        // durata delle pause del traffico bursty
+
+    // Popolarità delle chiavi cercate: "uniform" (ogni file al più una volta con arrival=fixed),
+    // "zipf" con esponente zipfAlpha, "hotset" (hotProbability dei lookup sulla frazione hotFraction
+    // dei file) o "trace" (chiavi lette da traceFile e riprodotte in ordine)
+    std::string popularity;
+    double zipfAlpha;
+    double hotFraction;
+    double hotProbability;
+    std::string traceFile;
+    std::vector<std::string> traceKeys;     // righe della traccia, lette e validate in main
+
+    ChordConfig()
+        : m(14), numNodes(10), numFiles(5), numLookups(3), failingNodes(0), timeout(Seconds(5.0)),
+          successorListSize(3), hopTimeout(1.0), replicas(1), lookupMode("recursive"), alpha(1),
+          pnsCandidates(1), prs(false), cacheSize(0), cacheTtl(60.0),
+          stabilizePeriod(0.0), fixFingersPeriod(0.0), checkPredecessorPeriod(0.0),
+          joiningNodes(0), joinStart(10.0), joinWave(10), joinInterval(1.0),
+          churn("none"), sessionTime(120.0), downTime(60.0), churnShape(1.5), churnStart(10.0),
+          timeSeriesInterval(1.0), nodeStatsInterval(0.0),
+          engine("packet"), analyticDelay("underlay"), hopLatency(0.1), mpi(false), partition("block"),
+          topology("default"), linkDelay(0.05), linkRate("10Mbps"), baLinks(3), domainSize(8), transitNodes(0),
+          arrival("fixed"), rate(10.0), warmup(0.0), duration(0.0), burstOn(1.0), burstOff(1.0),
+          popularity("uniform"), zipfAlpha(1.0), hotFraction(0.1), hotProbability(0.9) {}
+};
+
+// Vero se id cade nell'intervallo circolare (start, end]
+inline bool IsInRingRange(ChordId id, ChordId start, ChordId end) {
+    if (start < end) {
+        return id > start && id <= end;
+    } else {
+        return id > start || id <= end;
+    }
+}
+
+// Finger table in forma piatta per la ricerca del prossimo hop: le distanze in senso orario dal nodo
+// (i finger ruotati rispetto a self) in un array contiguo e ordinato, senza i finger verso se stesso.
+// L'intervallo circolare (self, target] diventa il confronto senza segno distanza <= distanza del
+// target, e i finger che precedono il target sono un prefisso trovato con una ricerca binaria
+class FlatFingerTable {
+private:
+    ChordId self;
+    uint32_t m;
+    std::vector<ChordId> offsets;
+
+public:
+    FlatFingerTable() : self(0), m(0) {}
+
+    void Build(ChordId id, const std::vector<ChordId>& fingers, uint32_t bits) {
+        self = id;
+        m = bits;
+        offsets.clear();
+        for (ChordId finger : fingers) {
+            ChordId offset = IdSub(finger, self, m);
+            if (offset != ChordId(0)) {
+                offsets.push_back(offset);
+            }
+        }
+        std::sort(offsets.begin(), offsets.end());
+        offsets.erase(std::unique(offsets.begin(), offsets.end()), offsets.end());
+    }
+
+    ChordId Offset(ChordId id) const {
+        return IdSub(id, self, m);
+    }
+
+    // Finger a distanza al più limit: le iterazioni dipendono solo dal numero di finger e il
+    // confronto diventa una mossa condizionale
+    size_t CountUpTo(ChordId limit) const {
+        if (offsets.empty()) {
+            return 0;
+        }
+        const ChordId* base = offsets.data();
+        size_t n = offsets.size();
+        while (n > 1) {
+            size_t half = n / 2;
+            base = base[half] <= limit ? base + half : base;
+            n -= half;
+        }
+        return (base - offsets.data()) + (*base <= limit ? 1 : 0);
+    }
+
+    // i-esimo finger in ordine di distanza
+    ChordId At(size_t i) const {
+        return IdAdd(self, offsets[i], m);
+    }
+};
+
+// Regola di instradamento di Chord, condivisa dalle applicazioni e dal motore analitico: il primo
+// successore utilizzabile se il target lo precede (ed è quindi il responsabile, isOwner), altrimenti
+// il finger più lontano che precede il target e poi un eventuale successore ancora più vicino.
+// usable esclude i vicini ritenuti guasti; restituisce self se non c'è un prossimo hop
+template <typename Usable>
+ChordId SelectNextHop(ChordId self, ChordId targetId, const FlatFingerTable& fingers,
+                      const std::vector<ChordId>& successors, Usable usable, bool& isOwner) {
+    isOwner = false;
+    if (targetId == self) {
+        return self;
+    }
+
+    ChordId successor = self;
+    for (ChordId id : successors) {
+        if (id != self && usable(id)) {
+            successor = id;
+            break;
+        }
+    }
+    if (successor == self) {
+        return self;
+    }
+    if (IsInRingRange(targetId, self, successor)) {
+        isOwner = true;
+        return successor;
+    }
+
+    ChordId best = successor;
+    for (size_t i = fingers.CountUpTo(fingers.Offset(targetId)); i-- > 0;) {
+        ChordId finger = fingers.At(i);
+        if (usable(finger)) {
+            best = finger;
+            break;
+        }
+    }
+    for (ChordId id : successors) {
+        if (id != self && usable(id) && IsInRingRange(id, best, targetId)) {
+            best = id;
+        }
+    }
+    isOwner = best == targetId;
+    return best;
+}
+
+class ChordApplication : public Application {
+private:
+    ChordId chordId;
+    uint32_t port;
+    Ptr<Socket> socket;
+    std::vector<ChordId> fingerTable;
+    FlatFingerTable flatFingers;                     // fingerTable per FindNextHop, ricostruita a ogni modifica
+    std::vector<ChordId> successorList;
+    ChordId predecessor;
+    std::map<ChordId, Address> nodeAddresses;       // solo i vicini noti a questo nodo
+    Ptr<ChordAddressDirectory> directory;
+    std::set<ChordId> storedFiles;
+    bool isAlive;
+    
+    // Nodo da interrogare in un lookup iterativo: depth è il numero di hop del percorso
+    // che ha portato a lui, owner indica se è ritenuto responsabile della chiave
+    struct HopCandidate {
+        ChordId nodeId;
+        uint32_t depth;
+        bool owner;
+        Time sentTime;
+        EventId timeoutEvent;
+    };
+
+    struct LookupInfo {
+        uint32_t lookupId;
+        ChordId fileId;
+        Time startTime;
+        EventId timeoutEvent;
+        // Ricerca iterativa condotta dall'origine
+        bool iterative;
+        std::vector<HopCandidate> candidates;   // nodi indicati e non ancora interrogati
+        std::vector<HopCandidate> inFlight;     // FIND_NEXT_HOP in attesa di risposta
+        std::set<ChordId> queried;
+        uint32_t maxDepth;
+        // Modalità semi: ultimo hop che ha notificato l'avanzamento della richiesta ricorsiva
+        bool hasProgress;
+        ChordId progressNode;
+        uint32_t progressDepth;
+        EventId stallEvent;
+
+        LookupInfo()
+            : lookupId(0), fileId(0), iterative(false), maxDepth(0),
+              hasProgress(false), progressNode(0), progressDepth(0) {}
+    };
+    PendingLookupTable<LookupInfo> pendingLookups;   // indicizzata dal nonce del lookup
+
+    // Richieste inoltrate in attesa del LOOKUP_ACK del prossimo hop, indicizzate dal nonce
+    struct ForwardInfo {
+        ChordMessage msg;
+        ChordId nextHop;
+        Time sentTime;
+        EventId timeoutEvent;
+    };
+    PendingLookupTable<ForwardInfo> pendingForwards;
+    std::set<ChordId> suspectedNodes;              // vicini che non hanno confermato un hop
+
+    // Stima dell'RTT verso ogni vicino (in secondi), alla maniera del RTO di TCP
+    struct RttEstimate {
+        double srtt;
+        double rttvar;
+    };
+    std::map<ChordId, RttEstimate> rttEstimates;
+
+    uint32_t successorListSize;
+    double hopTimeout;
+    uint32_t replicas;
+    uint64_t replicaMessages;       // STORE_FILE inviati alle repliche
+    uint64_t replicaBytes;
+
+    enum LookupMode {
+        LOOKUP_RECURSIVE,
+        LOOKUP_ITERATIVE,
+        LOOKUP_SEMI
+    };
+    LookupMode lookupMode;
+    uint32_t alpha;
+    uint32_t pnsCandidates;
+    bool prs;
+    LocationCache locationCache;
+    uint64_t cacheHits;             // lookup instradati direttamente verso il nodo in cache
+    uint64_t requestsHandled;       // LOOKUP_REQUEST e FIND_NEXT_HOP ricevute
+    uint64_t requestsServed;        // richieste a cui il nodo ha risposto con il file
+    uint64_t lookupMessages;        // richieste, risposte, conferme e notifiche dei lookup
+    uint64_t lookupBytes;
+
+    // Manutenzione dell'anello: una richiesta senza risposta entro il round successivo
+    // indica che il vicino è guasto
+    uint32_t m;
+    double stabilizePeriod;
+    double fixFingersPeriod;
+    double checkPredecessorPeriod;
+    bool hasPredecessor;
+    EventId stabilizeEvent;
+    EventId fixFingersEvent;
+    EventId checkPredecessorEvent;
+    bool stabilizePending;
+    ChordId stabilizeTarget;
+    bool pingPending;
+    uint32_t nextFinger;
+    uint32_t nextControlNonce;
+
+    // Ingresso nell'anello tramite un nodo di bootstrap
+    bool joining;
+    ChordId bootstrapId;
+    uint32_t joinAttempts;
+    Time joinStartTime;
+    EventId joinTimeoutEvent;
+    uint64_t keysTransferred;       // chiavi cedute ai nodi entrati
+    uint64_t keyTransferBytes;
+
+    // chordId, latenza dell'ingresso, esito
+    typedef Callback<void, ChordId, Time, bool> JoinCallback;
+    JoinCallback joinCallback;
+
+    // Traffico di controllo inviato (byte a livello IP, inclusi gli header UDP/IPv4)
+    static const uint32_t UDP_IP_OVERHEAD = 28;
+    uint64_t controlMessages;
+    uint64_t controlBytes;
+    std::vector<MessageCounters> messageCounters;   // indicizzati per MessageType
+    
+    // success, hop, lookupId, latenza end-to-end, timeout
+    typedef Callback<void, bool, uint32_t, uint32_t, Time, bool> StatsCallback;
+    StatsCallback statsCallback;
+
+public:
+    static TypeId GetTypeId(void) {
+        static TypeId tid = TypeId("ChordApplication")
+            .SetParent<Application>()
+            .AddConstructor<ChordApplication>();
+        return tid;
+    }
+    
+    static uint32_t nextLookupId;
+
+    // Attesa massima di ogni tentativo di ingresso e numero di tentativi (inclusi i reindirizzamenti)
+    static constexpr double JOIN_RETRY_INTERVAL = 2.0;
+    static const uint32_t MAX_JOIN_ATTEMPTS = 8;
+    static const uint32_t KEY_BATCH_SIZE = 256;
+
+    // Timeout di una richiesta verso un vicino senza campioni di RTT quando le conferme
+    // hop-by-hop sono disattivate
+    static constexpr double DEFAULT_HOP_TIMEOUT = 1.0;
+    static const uint32_t MAX_LOOKUP_HOPS = 50;
+
+    ChordApplication()
+        : port(9), isAlive(true), successorListSize(1), hopTimeout(0.0), replicas(1), replicaMessages(0), replicaBytes(0),
+          lookupMode(LOOKUP_RECURSIVE), alpha(1), pnsCandidates(1), prs(false), cacheHits(0), requestsHandled(0), requestsServed(0), lookupMessages(0), lookupBytes(0),
+          m(14), stabilizePeriod(0.0), fixFingersPeriod(0.0), checkPredecessorPeriod(0.0),
+          hasPredecessor(false), stabilizePending(false), stabilizeTarget(0), pingPending(false),
+          nextFinger(0), nextControlNonce(0), joining(false), bootstrapId(0), joinAttempts(0),
+          keysTransferred(0), keyTransferBytes(0), controlMessages(0), controlBytes(0),
+          messageCounters(ChordMessage::TYPE_COUNT) {
+    }
+
+    void Configure(const ChordConfig& config) {
+        successorListSize = config.successorListSize;
+        hopTimeout = config.hopTimeout;
+        replicas = config.replicas;
+        if (config.lookupMode == "iterative") {
+            lookupMode = LOOKUP_ITERATIVE;
+        } else if (config.lookupMode == "semi") {
+            lookupMode = LOOKUP_SEMI;
+        } else {
+            lookupMode = LOOKUP_RECURSIVE;
+        }
+        alpha = config.alpha;
+        pnsCandidates = config.pnsCandidates;
+        prs = config.prs;
+        locationCache.Configure(config.cacheSize, Seconds(config.cacheTtl));
+        m = config.m;
+        stabilizePeriod = config.stabilizePeriod;
+        fixFingersPeriod = config.fixFingersPeriod;
+        checkPredecessorPeriod = config.checkPredecessorPeriod;
+    }
+
+    void Setup(ChordId id, const std::vector<ChordId>& ft, 
+               const std::vector<ChordId>& sl, ChordId pred) {
+        chordId = id;
+        fingerTable = ft;
+        flatFingers.Build(chordId, fingerTable, m);
+        successorList = sl;
+        predecessor = pred;
+        hasPredecessor = (pred != id);
+
+        nodeAddresses.clear();
+        for (ChordId id : fingerTable) {
+            LearnAddress(id);
+        }
+        for (ChordId id : successorList) {
+            LearnAddress(id);
+        }
+        LearnAddress(predecessor);
+        
+        NS_LOG_DEBUG("Node " << chordId << " initialized with " 
+                     << fingerTable.size() << " finger table entries and "
+                     << successorList.size() << " successori (" << FormatIds(successorList) << ")");
+    }
+
+    // Chiavi già memorizzate all'avvio (anello ripristinato da un'istantanea)
+    void PreloadFiles(const std::set<ChordId>& keys) {
+        storedFiles.insert(keys.begin(), keys.end());
+    }
+
+    // RTT iniziali verso i vicini, come se fossero stati misurati all'ingresso nell'anello
+    void SetNeighborRtts(const std::map<ChordId, double>& rtts) {
+        for (const auto& entry : rtts) {
+            rttEstimates[entry.first] = {entry.second, entry.second / 2};
+        }
+    }
+
+    // Deve essere chiamata prima di Setup, che risolve tramite la directory gli indirizzi dei vicini
+    void SetAddressDirectory(Ptr<ChordAddressDirectory> dir) {
+        directory = dir;
+    }
+
+    void StartApplication() override {
+        NS_LOG_FUNCTION(this << chordId);
+        socket = Socket::CreateSocket(GetNode(), UdpSocketFactory::GetTypeId());
+        InetSocketAddress local = InetSocketAddress(Ipv4Address::GetAny(), port);
+        socket->Bind(local);
+        socket->SetRecvCallback(MakeCallback(&ChordApplication::HandleRead, this));
+        StartMaintenance();
+        NS_LOG_DEBUG("Node " << chordId << " application started");
+    }
+
+    void StopApplication() override {
+        NS_LOG_FUNCTION(this << chordId);
+        StopMaintenance();
+        if (socket) {
+            socket->Close();
+        }
+        NS_LOG_DEBUG("Il nodo " << chordId << " è spento");
+    }
+
+    bool IsStarted() const {
+        return (socket != nullptr);
+    }
+
+    void SetAlive(bool alive) {
+        NS_LOG_FUNCTION(this << chordId << alive);
+        isAlive = alive;
+        if (!alive) {
+            StopMaintenance();
+            NS_LOG_INFO("Node " << chordId << " è ora spento");
+        }
+    }
+
+    // Riaccende un nodo uscito per churn: lo stato di routing riparte da zero e il nodo
+    // rientra con il protocollo di JOIN; i file memorizzati sono persistenti e vengono conservati
+    void Restart(ChordId bootstrap) {
+        NS_LOG_FUNCTION(this << chordId << bootstrap);
+        isAlive = true;
+        successorList.clear();
+        fingerTable.assign(m, chordId);
+        flatFingers.Build(chordId, fingerTable, m);
+        predecessor = chordId;
+        hasPredecessor = false;
+        suspectedNodes.clear();
+        rttEstimates.clear();
+        nodeAddresses.clear();
+        locationCache.Clear();
+        stabilizePending = false;
+        pingPending = false;
+        if (socket) {
+            StartMaintenance();
+        }
+        Join(bootstrap);
+    }
+
+    uint64_t GetControlMessages() const {
+        return controlMessages;
+    }
+
+    uint64_t GetControlBytes() const {
+        return controlBytes;
+    }
+
+    uint64_t GetKeysTransferred() const {
+        return keysTransferred;
+    }
+
+    uint64_t GetStoredKeys() const {
+        return storedFiles.size();
+    }
+
+    uint64_t GetReplicaMessages() const {
+        return replicaMessages;
+    }
+
+    uint64_t GetReplicaBytes() const {
+        return replicaBytes;
+    }
+
+    uint64_t GetLookupMessages() const {
+        return lookupMessages;
+    }
+
+    uint64_t GetCacheHits() const {
+        return cacheHits;
+    }
+
+    const std::vector<MessageCounters>& GetMessageCounters() const {
+        return messageCounters;
+    }
+
+    ChordId GetChordId() const {
+        return chordId;
+    }
+
+    bool IsAlive() const {
+        return isAlive;
+    }
+
+    uint64_t GetRequestsHandled() const {
+        return requestsHandled;
+    }
+
+    uint64_t GetRequestsServed() const {
+        return requestsServed;
+    }
+
+    uint64_t GetLookupBytes() const {
+        return lookupBytes;
+    }
+
+    uint64_t GetKeyTransferBytes() const {
+        return keyTransferBytes;
+    }
+
+    void SetJoinCallback(JoinCallback callback) {
+        joinCallback = callback;
+    }
+
+    // Avvia l'ingresso nell'anello: il successore viene cercato tramite il nodo di bootstrap,
+    // poi gli si invia la JOIN per ottenere predecessore, successor list e chiavi
+    void Join(ChordId bootstrap) {
+        NS_LOG_FUNCTION(this << chordId << bootstrap);
+        joining = true;
+        bootstrapId = bootstrap;
+        joinAttempts = 0;
+        joinStartTime = Simulator::Now();
+        NS_LOG_INFO("Il nodo " << chordId << " entra nell'anello tramite il nodo " << bootstrap);
+        SendJoinLookup();
+    }
+
+    void SendMessage(Ptr<Packet> packet, Address targetAddress) {
+        uint8_t type = 0;
+        packet->CopyData(&type, 1);
+        MessageCounters& counters = messageCounters[std::min<uint32_t>(type, ChordMessage::TYPE_COUNT - 1)];
+        if (!isAlive || !socket) {
+            counters.dropped++;
+            NS_LOG_WARN("Il nodo " << chordId << " non può inviare un messaggio: " 
+                        << (isAlive ? "socket è nullo" : "il nodo è spento"));
+            return;
+        }
+
+        NS_LOG_INFO("Il nodo " << chordId << " sta inviando un messaggio " 
+                    << DescribePacket(packet) << " a "
+                    << InetSocketAddress::ConvertFrom(targetAddress).GetIpv4());
+        
+        counters.sentPackets++;
+        counters.sentBytes += packet->GetSize() + UDP_IP_OVERHEAD;
+        socket->SendTo(packet, 0, targetAddress);
+    }
+
+    // Prossimo hop verso targetId, saltando i vicini sospettati di essere guasti.
+    // isOwner indica se il nodo restituito è ritenuto responsabile della chiave
+    ChordId FindNextHop(ChordId targetId, bool* isOwner = nullptr) {
+        NS_LOG_LOGIC("Il nodo " << chordId << " cerca il prossimo nodo per targetId " << targetId
+                     << ", finger table: " << FormatIds(fingerTable)
+                     << ", successori: " << FormatIds(successorList));
+        bool owner = false;
+        ChordId best = SelectNextHop(chordId, targetId, flatFingers, successorList,
+                                     [this](ChordId id) { return !IsSuspected(id); }, owner);
+        if (prs && best != chordId && !owner) {
+            best = SelectProximateHop(targetId, best);
+            owner = best == targetId;
+        }
+        if (isOwner) {
+            *isOwner = owner;
+        }
+        NS_LOG_LOGIC("Il nodo " << chordId << " sceglie il nodo " << best << " per target " << targetId
+                     << (owner ? " (responsabile)" : ""));
+        return best;
+    }
+
+    void SetStatsCallback(StatsCallback callback) {
+        statsCallback = callback;
+    }
+
+    void PerformLookup(ChordId fileId, Time timeout, uint32_t lookupId) {
+        NS_LOG_FUNCTION(this << chordId << fileId << lookupId);
+        
+        if (!isAlive || !socket) {
+            NS_LOG_WARN("Node " << chordId << " cannot perform lookup: " 
+                        << (isAlive ? "socket is null" : "node is down"));
+            if (!statsCallback.IsNull()) {
+                statsCallback(false, 0, lookupId, Seconds(0), false);
+            }
+            return;
+        }
+        
+        NS_LOG_LOGIC("Node " << chordId << " ha " << storedFiles.size() << " file memorizzati: " << FormatIds(storedFiles));
+        
+        // Verifica se abbiamo già il file localmente
+        if (storedFiles.count(fileId) > 0) {
+            NS_LOG_INFO("Node " << chordId << " already has file " << fileId << " locally");
+            if (!statsCallback.IsNull()) {
+                statsCallback(true, 0, lookupId, Seconds(0), false);
+            }
+            return;
+        }
+        
+        ChordMessage msg;
+        msg.type = ChordMessage::LOOKUP_REQUEST;
+        msg.senderId = chordId;
+        msg.originId = chordId;  // Il nodo che avvia il lookup è anche l'origine
+        msg.targetId = fileId;
+        msg.hopCount = 0;
+        msg.success = false;
+        msg.options |= ChordMessage::OPT_NONCE;
+        msg.nonce = lookupId;   // l'ID del lookup è unico e fa da nonce
+
+        NS_LOG_INFO("Il nodo " << chordId << " sta iniziando una lookup " << lookupId << " per il file " << fileId);
+
+        // Salva le informazioni del lookup: più lookup concorrenti per lo stesso file restano distinte
+        LookupInfo& info = pendingLookups.Insert(msg.nonce);
+        info.fileId = fileId;
+        info.lookupId = lookupId;
+        info.startTime = Simulator::Now();
+        info.timeoutEvent = Simulator::Schedule(timeout, &ChordApplication::HandleLookupTimeout, this, msg.nonce);
+
+        if (lookupMode == LOOKUP_ITERATIVE) {
+            info.iterative = true;
+            ChordId cached;
+            if (locationCache.Lookup(fileId, cached) && cached != chordId && !IsSuspected(cached)) {
+                cacheHits++;
+                AddCandidates(info, std::vector<ChordId>(1, cached), 0, true);
+            }
+            bool owner = false;
+            std::vector<ChordId> nodes = GetNextHopCandidates(fileId, alpha + 1, owner);
+            AddCandidates(info, nodes, 0, owner);
+            IssueNextHopQueries(msg.nonce);
+            return;
+        }
+        if (lookupMode == LOOKUP_SEMI) {
+            info.stallEvent = Simulator::Schedule(GetStallTimeout(), &ChordApplication::HandleLookupStall, this, msg.nonce);
+        }
+
+        if (!SendCachedLookupHop(msg) && !SendLookupHop(msg)) {
+            NS_LOG_WARN("Il nodo " << chordId << " non ha un prossimo hop valido per il file " << fileId);
+            CompleteLookup(msg.nonce, false, 0, false);
+        }
+    }
+
+private:
+    void HandleRead(Ptr<Socket> socket) {
+        if (!isAlive) return;
+
+        Ptr<Packet> packet;
+        Address from;
+        while ((packet = socket->RecvFrom(from))) {
+            if (packet->GetSize() < ChordHeader::MIN_SIZE) {
+                NS_LOG_WARN("Il nodo " << chordId << " ha ricevuto un pacchetto troppo corto (" << packet->GetSize() << " byte)");
+                continue;
+            }
+            uint32_t size = packet->GetSize();
+            ChordHeader header;
+            packet->RemoveHeader(header);
+            const ChordMessage& msg = header.GetMessage();
+            if (msg.type >= ChordMessage::TYPE_COUNT) {
+                NS_LOG_WARN("Il nodo " << chordId << " ha ricevuto un messaggio di tipo sconosciuto " << (uint32_t)msg.type);
+                continue;
+            }
+            messageCounters[msg.type].receivedPackets++;
+            messageCounters[msg.type].receivedBytes += size + UDP_IP_OVERHEAD;
+
+            NS_LOG_INFO("Il nodo " << chordId << " ha ricevuto un messaggio " 
+                        << DescribeMessage(msg) << " dal nodo " << msg.senderId);
+
+            // Un vicino che risponde non è più sospettato
+            if (suspectedNodes.erase(msg.senderId) > 0) {
+                NS_LOG_INFO("Il nodo " << chordId << " non sospetta più il nodo " << msg.senderId);
+            }
+
+            switch (msg.type) {
+                case ChordMessage::LOOKUP_REQUEST:
+                    HandleLookup(msg, from);
+                    break;
+                case ChordMessage::LOOKUP_RESPONSE:
+                    HandleLookupResponse(msg);
+                    break;
+                case ChordMessage::STORE_FILE:
+                    HandleStore(msg, from);
+                    break;
+                case ChordMessage::LOOKUP_ACK:
+                    HandleLookupAck(msg);
+                    break;
+                case ChordMessage::STABILIZE:
+                    HandleStabilize(msg, from);
+                    break;
+                case ChordMessage::STABILIZE_REPLY:
+                    HandleStabilizeReply(msg);
+                    break;
+                case ChordMessage::NOTIFY:
+                    HandleNotify(msg);
+                    break;
+                case ChordMessage::FIND_SUCCESSOR:
+                    HandleFindSuccessor(msg);
+                    break;
+                case ChordMessage::FIND_SUCCESSOR_REPLY:
+                    HandleFindSuccessorReply(msg);
+                    break;
+                case ChordMessage::PING:
+                    HandlePing(msg, from);
+                    break;
+                case ChordMessage::PONG:
+                    HandlePong(msg);
+                    break;
+                case ChordMessage::JOIN:
+                    HandleJoin(msg, from);
+                    break;
+                case ChordMessage::JOIN_REPLY:
+                    HandleJoinReply(msg);
+                    break;
+                case ChordMessage::KEY_TRANSFER:
+                    HandleKeyTransfer(msg);
+                    break;
+                case ChordMessage::FIND_NEXT_HOP:
+                    HandleFindNextHop(msg, from);
+                    break;
+                case ChordMessage::NEXT_HOP_REPLY:
+                    HandleNextHopReply(msg);
+                    break;
+                case ChordMessage::LOOKUP_PROGRESS:
+                    HandleLookupProgress(msg);
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+
+    void HandleLookup(const ChordMessage& msg, const Address& from) {
+        NS_LOG_FUNCTION(this << chordId << msg.targetId);
+        requestsHandled++;
+
+        if (hopTimeout > 0 && msg.HasOption(ChordMessage::OPT_NONCE)) {
+            SendLookupAck(msg, from);
+        }
+
+        if (msg.hopCount > MAX_LOOKUP_HOPS) { 
+            NS_LOG_WARN("Rilevato possibile ciclo di routing per il file " << msg.targetId 
+                        << " dopo " << msg.hopCount << " hop. Interrompo la ricerca.");
+            SendLookupResponse(msg, false, msg.hopCount, from);
+            return;
+        }
+
+        NS_LOG_LOGIC("Il nodo " << chordId << " ha " << storedFiles.size() << " file memorizzati: " << FormatIds(storedFiles));
+
+        if (storedFiles.find(msg.targetId) != storedFiles.end()) {
+            NS_LOG_INFO("Il nodo " << chordId << " ha il file " << msg.targetId 
+                        << ". Inviamo la risposta dopo " << msg.hopCount << " hop");
+            requestsServed++;
+            SendLookupResponse(msg, true, msg.hopCount + 1, from);
+            return;
+        } else {
+            NS_LOG_LOGIC("Node " << chordId << " NON ha il file " << msg.targetId);
+        }
+
+        if (lookupMode == LOOKUP_SEMI && msg.originId != chordId && msg.HasOption(ChordMessage::OPT_NONCE)) {
+            SendLookupProgress(msg);
+        }
+
+        ChordMessage forward = msg;
+        forward.senderId = chordId;
+        forward.hopCount++;
+
+        // Il mittente ci ritiene responsabili della chiave: se lo siamo davvero il file non esiste,
+        // altrimenti la chiave è passata al predecessore entrato da poco nell'anello
+        if (msg.HasOption(ChordMessage::OPT_OWNER)) {
+            if (!hasPredecessor || IsInRange(msg.targetId, predecessor, chordId)) {
+                NS_LOG_INFO("Il nodo " << chordId << " è responsabile del file " << msg.targetId << " ma non lo possiede");
+                SendLookupResponse(msg, false, msg.hopCount + 1, from);
+                return;
+            }
+            if (!IsSuspected(predecessor) && SendLookupHopTo(forward, predecessor, true)) {
+                return;
+            }
+        }
+
+        if (!SendCachedLookupHop(forward) && !SendLookupHop(forward)) {
+            NS_LOG_WARN("Il nodo " << chordId << " non ha un prossimo hop valido per il file " << msg.targetId);
+            SendLookupResponse(msg, false, msg.hopCount, from);
+        }
+    }
+
+    // Inoltra una LOOKUP_REQUEST al prossimo hop vivo; se le conferme sono attive la richiesta
+    // resta in pendingForwards finché il prossimo hop non invia il LOOKUP_ACK
+    bool SendLookupHop(const ChordMessage& forward) {
+        bool isOwner = false;
+        ChordId nextHop = FindNextHop(forward.targetId, &isOwner);
+        if (nextHop == chordId) {
+            return false;
+        }
+        return SendLookupHopTo(forward, nextHop, isOwner);
+    }
+
+    // Scorciatoia verso il nodo che ha già risposto per la stessa chiave, se è in cache: viene
+    // interrogato come responsabile, quindi se non ha più il file la richiesta torna sul percorso normale
+    bool SendCachedLookupHop(const ChordMessage& forward) {
+        ChordId cached;
+        if (!locationCache.Lookup(forward.targetId, cached) || cached == chordId || IsSuspected(cached)) {
+            return false;
+        }
+        NS_LOG_LOGIC("Il nodo " << chordId << " trova in cache il nodo " << cached << " per il file " << forward.targetId);
+        cacheHits++;
+        return SendLookupHopTo(forward, cached, true);
+    }
+
+    bool SendLookupHopTo(ChordMessage forward, ChordId nextHop, bool isOwner) {
+        Address nextHopAddress;
+        if (!ResolveAddress(nextHop, nextHopAddress)) {
+            NS_LOG_ERROR("Impossibile trovare l'indirizzo per il nodo " << nextHop);
+            return false;
+        }
+
+        if (isOwner) {
+            forward.options |= ChordMessage::OPT_OWNER;
+        } else {
+            forward.options &= ~ChordMessage::OPT_OWNER;
+        }
+
+        NS_LOG_INFO("Il nodo " << chordId << " sta inoltrando una lookup per il file " 
+                    << forward.targetId << " al nodo " << nextHop);
+        if (forward.originId != chordId) {
+            messageCounters[ChordMessage::LOOKUP_REQUEST].forwarded++;
+        }
+
+        if (hopTimeout > 0 && forward.HasOption(ChordMessage::OPT_NONCE)) {
+            ForwardInfo* previous = pendingForwards.Find(forward.nonce);
+            ForwardInfo& info = previous ? *previous : pendingForwards.Insert(forward.nonce);
+            Simulator::Cancel(info.timeoutEvent);
+            info.msg = forward;
+            info.nextHop = nextHop;
+            info.sentTime = Simulator::Now();
+            info.timeoutEvent = Simulator::Schedule(GetHopTimeout(nextHop), &ChordApplication::HandleHopTimeout,
+                                                    this, forward.nonce);
+        }
+
+        SendLookupMessage(forward, nextHopAddress);
+        return true;
+    }
+
+    void SendLookupAck(const ChordMessage& request, const Address& from) {
+        ChordMessage ack;
+        ack.type = ChordMessage::LOOKUP_ACK;
+        ack.senderId = chordId;
+        ack.originId = request.originId;
+        ack.targetId = request.targetId;
+        ack.hopCount = request.hopCount;
+        ack.options = ChordMessage::OPT_NONCE;
+        ack.nonce = request.nonce;
+        SendLookupMessage(ack, from);
+    }
+
+    void HandleLookupAck(const ChordMessage& msg) {
+        ForwardInfo* info = pendingForwards.Find(msg.nonce);
+        if (!info || info->nextHop != msg.senderId) {
+            return;
+        }
+        Simulator::Cancel(info->timeoutEvent);
+        UpdateRtt(msg.senderId, Simulator::Now() - info->sentTime);
+        pendingForwards.Erase(msg.nonce);
+    }
+
+    // Il prossimo hop non ha confermato: viene sospettato e la richiesta reinstradata
+    // sul finger o successore successivo
+    void HandleHopTimeout(uint32_t nonce) {
+        ForwardInfo* info = pendingForwards.Find(nonce);
+        if (!info) {
+            return;
+        }
+        if (!isAlive) {
+            pendingForwards.Erase(nonce);
+            return;
+        }
+        ChordMessage forward = info->msg;
+        ChordId deadHop = info->nextHop;
+        pendingForwards.Erase(nonce);
+
+        NS_LOG_INFO("Il nodo " << chordId << " non ha ricevuto conferma dal nodo " << deadHop
+                    << " per il file " << forward.targetId << ", lo considera sospetto");
+        messageCounters[ChordMessage::LOOKUP_REQUEST].timeouts++;
+        suspectedNodes.insert(deadHop);
+        rttEstimates.erase(deadHop);
+        locationCache.EraseNode(deadHop);
+
+        if (SendLookupHop(forward)) {
+            return;
+        }
+
+        NS_LOG_WARN("Il nodo " << chordId << " non ha percorsi alternativi per il file " << forward.targetId);
+        if (forward.originId == chordId) {
+            CompleteLookup(nonce, false, forward.hopCount, false);
+        } else {
+            SendLookupResponse(forward, false, forward.hopCount, Address());
+        }
+    }
+
+    // Risponde direttamente al nodo che ha avviato il lookup; se il suo indirizzo non è noto
+    // la risposta torna al mittente della richiesta
+    void SendLookupResponse(const ChordMessage& request, bool success, uint32_t hopCount, const Address& from) {
+        ChordMessage response;
+        response.type = ChordMessage::LOOKUP_RESPONSE;
+        response.senderId = chordId;
+        response.originId = request.originId;
+        response.targetId = request.targetId;
+        response.success = success;
+        response.hopCount = hopCount;
+        response.options = request.options & ChordMessage::OPT_NONCE;
+        response.nonce = request.nonce;
+
+        Address originAddress;
+        if (ResolveAddress(request.originId, originAddress)) {
+            SendLookupMessage(response, originAddress);
+            NS_LOG_LOGIC("Inviata risposta " << (success ? "positiva" : "negativa") 
+                         << " direttamente al nodo originale " << request.originId);
+        } else if (!from.IsInvalid()) {
+            SendLookupMessage(response, from);
+            NS_LOG_LOGIC("Inviata risposta " << (success ? "positiva" : "negativa") 
+                         << " al mittente (non trovato indirizzo del nodo originale)");
+        } else {
+            NS_LOG_ERROR("Impossibile trovare l'indirizzo del nodo originale " << request.originId);
+        }
+    }
+
+    void HandleLookupResponse(const ChordMessage& msg) {
+        NS_LOG_FUNCTION(this << chordId << msg.targetId);
+        NS_LOG_INFO("Il nodo " << chordId << " ha ricevuto una risposta per il file " 
+                    << msg.targetId << " dopo " << msg.hopCount << " hop");
+        
+        if (msg.originId != chordId) {
+            NS_LOG_WARN("Il nodo " << chordId << " ha ricevuto una risposta per un lookup che non ha avviato. OriginId: " << msg.originId);
+            return;
+        }
+        
+        if (!msg.HasOption(ChordMessage::OPT_NONCE)) {
+            NS_LOG_WARN("Il nodo " << chordId << " ha ricevuto una risposta senza nonce per il file " << msg.targetId);
+            return;
+        }
+        
+        if (!pendingLookups.Find(msg.nonce)) {
+            NS_LOG_WARN("Il nodo " << chordId << " ha ricevuto una risposta per un lookup non pendente. Nonce: " << msg.nonce
+                        << ", FileId: " << msg.targetId);
+            return;
+        }
+        if (msg.success) {
+            locationCache.Insert(msg.targetId, msg.senderId);
+        } else {
+            locationCache.Erase(msg.targetId);
+        }
+        CompleteLookup(msg.nonce, msg.success, msg.hopCount, false);
+    }
+
+    // Chiude un lookup avviato da questo nodo e notifica le statistiche
+    void CompleteLookup(uint32_t nonce, bool success, uint32_t hopCount, bool timedOut) {
+        LookupInfo* info = pendingLookups.Find(nonce);
+        if (!info) {
+            return;
+        }
+        Simulator::Cancel(info->timeoutEvent);
+        Simulator::Cancel(info->stallEvent);
+        for (HopCandidate& query : info->inFlight) {
+            Simulator::Cancel(query.timeoutEvent);
+        }
+        uint32_t lookupId = info->lookupId;
+        Time latency = Simulator::Now() - info->startTime;
+        pendingLookups.Erase(nonce);
+
+        // Il primo hop potrebbe non aver ancora confermato: il suo timer non serve più
+        ForwardInfo* forward = pendingForwards.Find(nonce);
+        if (forward) {
+            Simulator::Cancel(forward->timeoutEvent);
+            pendingForwards.Erase(nonce);
+        }
+
+        if (!statsCallback.IsNull()) {
+            NS_LOG_LOGIC("Il nodo " << chordId << " aggiorna le statistiche per il lookup " << lookupId 
+                         << " (success: " << (success ? "true" : "false") << ", hops: " << hopCount
+                         << ", latency: " << latency.GetMilliSeconds() << "ms)");
+            statsCallback(success, hopCount, lookupId, latency, timedOut);
+        } else {
+            NS_LOG_ERROR("Il nodo " << chordId << " non ha una callback per le statistiche!");
+        }
+    }
+
+    void HandleStore(const ChordMessage& msg, const Address& from) {
+        NS_LOG_FUNCTION(this << chordId << msg.targetId);
+
+        storedFiles.insert(msg.targetId);
+        NS_LOG_INFO("Node " << chordId << " ha memorizzato il file " << msg.targetId
+                    << (msg.HasOption(ChordMessage::OPT_REPLICA_HINT) ? " come replica" : ""));
+        NS_LOG_LOGIC("Node " << chordId << " ora ha " << storedFiles.size() << " file memorizzati: " << FormatIds(storedFiles));
+
+        // Il responsabile inoltra una copia ai primi replicas-1 successori vivi
+        if (!msg.HasOption(ChordMessage::OPT_REPLICA_HINT)) {
+            uint8_t replica = 1;
+            for (ChordId id : successorList) {
+                if (replica >= replicas) {
+                    break;
+                }
+                Address address;
+                if (id == chordId || IsSuspected(id) || !ResolveAddress(id, address)) {
+                    continue;
+                }
+                ChordMessage copy = msg;
+                copy.senderId = chordId;
+                copy.options |= ChordMessage::OPT_REPLICA_HINT;
+                copy.replicaHint = replica++;
+                Ptr<Packet> packet = CreateMessagePacket(copy);
+                replicaMessages++;
+                replicaBytes += packet->GetSize() + UDP_IP_OVERHEAD;
+                SendMessage(packet, address);
+            }
+        }
+
+        ChordMessage ack;
+        ack.type = ChordMessage::STORE_ACK;
+        ack.senderId = chordId;
+        ack.originId = msg.senderId;
+        ack.targetId = msg.targetId;
+        ack.success = true;
+        ack.hopCount = 0;
+        Ptr<Packet> packet = CreateMessagePacket(ack);
+        SendMessage(packet, from);
+    }
+
+    void HandleLookupTimeout(uint32_t nonce) {
+        LookupInfo* info = pendingLookups.Find(nonce);
+        if (!info) {
+            return;
+        }
+        NS_LOG_FUNCTION(this << chordId << info->fileId << info->lookupId);
+        NS_LOG_INFO("La ricerca " << info->lookupId << " del nodo " << chordId << " per il file " << info->fileId << " ha timeoutato");
+        messageCounters[ChordMessage::LOOKUP_RESPONSE].timeouts++;
+        CompleteLookup(nonce, false, 0, true);
+    }
+
+    // Invia un messaggio di lookup conteggiandolo nel traffico dei lookup
+    void SendLookupMessage(const ChordMessage& msg, const Address& address) {
+        Ptr<Packet> packet = CreateMessagePacket(msg);
+        if (isAlive && socket) {
+            lookupMessages++;
+            lookupBytes += packet->GetSize() + UDP_IP_OVERHEAD;
+        }
+        SendMessage(packet, address);
+    }
+
+    // Distanza in senso orario da from a to nello spazio degli identificatori
+    ChordId RingDistance(ChordId from, ChordId to) const {
+        return IdSub(to, from, m);
+    }
+
+    // Nodi a cui proseguire la ricerca di targetId, dal più promettente. Se il prossimo hop è
+    // responsabile della chiave (owner) seguono i successori vivi successivi, che la ereditano
+    // se il responsabile è guasto; altrimenti i finger e i successori che precedono il target
+    std::vector<ChordId> GetNextHopCandidates(ChordId targetId, uint32_t count, bool& owner) {
+        std::vector<ChordId> result;
+        ChordId best = FindNextHop(targetId, &owner);
+        if (best == chordId) {
+            return result;
+        }
+        result.push_back(best);
+
+        if (owner) {
+            bool after = false;
+            for (ChordId id : successorList) {
+                if (result.size() >= count) {
+                    break;
+                }
+                if (after && id != chordId && !IsSuspected(id)) {
+                    result.push_back(id);
+                }
+                after = after || id == best;
+            }
+            return result;
+        }
+
+        std::vector<ChordId> nodes(fingerTable);
+        nodes.insert(nodes.end(), successorList.begin(), successorList.end());
+        std::sort(nodes.begin(), nodes.end(), [this, targetId](ChordId a, ChordId b) {
+            return RingDistance(a, targetId) < RingDistance(b, targetId);
+        });
+        nodes.erase(std::unique(nodes.begin(), nodes.end()), nodes.end());
+        for (ChordId id : nodes) {
+            if (result.size() >= count) {
+                break;
+            }
+            if (id != chordId && id != best && id != targetId && !IsSuspected(id) && IsInRange(id, chordId, targetId)) {
+                result.push_back(id);
+            }
+        }
+        return result;
+    }
+
+    void AddCandidates(LookupInfo& info, const std::vector<ChordId>& nodes, uint32_t depth, bool owner) {
+        for (ChordId id : nodes) {
+            if (id == chordId || info.queried.count(id) > 0) {
+                continue;
+            }
+            auto it = std::find_if(info.candidates.begin(), info.candidates.end(),
+                                   [id](const HopCandidate& c) { return c.nodeId == id; });
+            if (it != info.candidates.end()) {
+                it->owner = it->owner || owner;
+                continue;
+            }
+            HopCandidate candidate;
+            candidate.nodeId = id;
+            candidate.depth = depth;
+            candidate.owner = owner;
+            info.candidates.push_back(candidate);
+        }
+    }
+
+    // Mantiene fino ad alpha FIND_NEXT_HOP in volo, interrogando prima i nodi ritenuti responsabili
+    // e poi i più vicini al target; senza richieste in volo né candidati il lookup fallisce
+    void IssueNextHopQueries(uint32_t nonce) {
+        LookupInfo* info = pendingLookups.Find(nonce);
+        if (!info) {
+            return;
+        }
+        while (info->inFlight.size() < alpha && !info->candidates.empty()) {
+            auto best = info->candidates.begin();
+            for (auto it = info->candidates.begin(); it != info->candidates.end(); ++it) {
+                if (it->owner != best->owner) {
+                    if (it->owner) {
+                        best = it;
+                    }
+                } else if (!it->owner && RingDistance(it->nodeId, info->fileId) < RingDistance(best->nodeId, info->fileId)) {
+                    best = it;
+                }
+            }
+            HopCandidate candidate = *best;
+            info->candidates.erase(best);
+
+            Address address;
+            if (IsSuspected(candidate.nodeId) || candidate.depth > MAX_LOOKUP_HOPS
+                || !ResolveAddress(candidate.nodeId, address)) {
+                continue;
+            }
+            info->queried.insert(candidate.nodeId);
+            info->maxDepth = std::max(info->maxDepth, candidate.depth);
+
+            ChordMessage query;
+            query.type = ChordMessage::FIND_NEXT_HOP;
+            query.senderId = chordId;
+            query.originId = chordId;
+            query.targetId = info->fileId;
+            query.hopCount = candidate.depth;
+            query.options = ChordMessage::OPT_NONCE | (candidate.owner ? ChordMessage::OPT_OWNER : 0);
+            query.nonce = nonce;
+
+            NS_LOG_INFO("Il nodo " << chordId << " interroga il nodo " << candidate.nodeId << " per il file "
+                        << info->fileId << " (profondità " << candidate.depth << (candidate.owner ? ", responsabile" : "") << ")");
+            candidate.sentTime = Simulator::Now();
+            candidate.timeoutEvent = Simulator::Schedule(GetHopTimeout(candidate.nodeId), &ChordApplication::HandleNextHopTimeout,
+                                                         this, nonce, candidate.nodeId);
+            info->inFlight.push_back(candidate);
+            SendLookupMessage(query, address);
+        }
+
+        if (info->inFlight.empty()) {
+            NS_LOG_WARN("Il nodo " << chordId << " non ha più nodi da interrogare per il file " << info->fileId);
+            CompleteLookup(nonce, false, info->maxDepth, false);
+        }
+    }
+
+    // Richiesta iterativa: il nodo non inoltra nulla, risponde all'origine con l'esito se è in grado
+    // di darlo, altrimenti con i nodi a cui proseguire
+    void HandleFindNextHop(const ChordMessage& msg, const Address& from) {
+        NS_LOG_FUNCTION(this << chordId << msg.targetId);
+        requestsHandled++;
+        ChordMessage reply;
+        reply.type = ChordMessage::NEXT_HOP_REPLY;
+        reply.senderId = chordId;
+        reply.originId = msg.originId;
+        reply.targetId = msg.targetId;
+        reply.hopCount = msg.hopCount;
+        reply.options = msg.options & ChordMessage::OPT_NONCE;
+        reply.nonce = msg.nonce;
+
+        if (storedFiles.count(msg.targetId) > 0) {
+            NS_LOG_INFO("Il nodo " << chordId << " ha il file " << msg.targetId);
+            requestsServed++;
+            reply.success = true;
+        } else if (msg.HasOption(ChordMessage::OPT_OWNER)
+                   && (!hasPredecessor || IsInRange(msg.targetId, predecessor, chordId))) {
+            // Responsabile senza il file: esito negativo definitivo, OPT_OWNER senza candidati
+            NS_LOG_INFO("Il nodo " << chordId << " è responsabile del file " << msg.targetId << " ma non lo possiede");
+            reply.options |= ChordMessage::OPT_OWNER;
+        } else if (msg.HasOption(ChordMessage::OPT_OWNER) && !IsSuspected(predecessor)) {
+            // La chiave è passata al predecessore entrato da poco nell'anello
+            reply.options |= ChordMessage::OPT_OWNER | ChordMessage::OPT_SUCCESSOR_LIST;
+            reply.successors.push_back(predecessor);
+        } else {
+            bool owner = false;
+            reply.successors = GetNextHopCandidates(msg.targetId, alpha + 1, owner);
+            reply.options |= ChordMessage::OPT_SUCCESSOR_LIST | (owner ? ChordMessage::OPT_OWNER : 0);
+        }
+        SendLookupMessage(reply, from);
+    }
+
+    void HandleNextHopReply(const ChordMessage& msg) {
+        LookupInfo* info = pendingLookups.Find(msg.nonce);
+        if (!info || !info->iterative) {
+            return;
+        }
+        auto it = std::find_if(info->inFlight.begin(), info->inFlight.end(),
+                               [&msg](const HopCandidate& c) { return c.nodeId == msg.senderId; });
+        if (it == info->inFlight.end()) {
+            return;
+        }
+        Simulator::Cancel(it->timeoutEvent);
+        UpdateRtt(msg.senderId, Simulator::Now() - it->sentTime);
+        uint32_t depth = it->depth;
+        info->inFlight.erase(it);
+
+        if (msg.success) {
+            locationCache.Insert(msg.targetId, msg.senderId);
+            CompleteLookup(msg.nonce, true, depth + 1, false);
+            return;
+        }
+        if (msg.HasOption(ChordMessage::OPT_OWNER) && !msg.HasOption(ChordMessage::OPT_SUCCESSOR_LIST)) {
+            locationCache.Erase(msg.targetId);
+            CompleteLookup(msg.nonce, false, depth + 1, false);
+            return;
+        }
+        AddCandidates(*info, msg.successors, depth + 1, msg.HasOption(ChordMessage::OPT_OWNER));
+        IssueNextHopQueries(msg.nonce);
+    }
+
+    // Il nodo interrogato non ha risposto: viene sospettato e la ricerca prosegue sugli altri candidati
+    void HandleNextHopTimeout(uint32_t nonce, ChordId nodeId) {
+        LookupInfo* info = pendingLookups.Find(nonce);
+        if (!info || !isAlive) {
+            return;
+        }
+        auto it = std::find_if(info->inFlight.begin(), info->inFlight.end(),
+                               [nodeId](const HopCandidate& c) { return c.nodeId == nodeId; });
+        if (it == info->inFlight.end()) {
+            return;
+        }
+        info->inFlight.erase(it);
+        NS_LOG_INFO("Il nodo " << chordId << " non ha ricevuto risposta dal nodo " << nodeId
+                    << " per il file " << info->fileId << ", lo considera sospetto");
+        messageCounters[ChordMessage::FIND_NEXT_HOP].timeouts++;
+        suspectedNodes.insert(nodeId);
+        rttEstimates.erase(nodeId);
+        locationCache.EraseNode(nodeId);
+        IssueNextHopQueries(nonce);
+    }
+
+    // Modalità semi: un hop intermedio conferma all'origine di aver ricevuto la richiesta
+    void SendLookupProgress(const ChordMessage& request) {
+        Address originAddress;
+        if (!ResolveAddress(request.originId, originAddress)) {
+            return;
+        }
+        ChordMessage progress;
+        progress.type = ChordMessage::LOOKUP_PROGRESS;
+        progress.senderId = chordId;
+        progress.originId = request.originId;
+        progress.targetId = request.targetId;
+        progress.hopCount = request.hopCount;
+        progress.options = ChordMessage::OPT_NONCE;
+        progress.nonce = request.nonce;
+        SendLookupMessage(progress, originAddress);
+    }
+
+    void HandleLookupProgress(const ChordMessage& msg) {
+        LookupInfo* info = pendingLookups.Find(msg.nonce);
+        if (!info || info->iterative) {
+            return;
+        }
+        if (!info->hasProgress || msg.hopCount >= info->progressDepth) {
+            info->hasProgress = true;
+            info->progressNode = msg.senderId;
+            info->progressDepth = msg.hopCount;
+        }
+        Simulator::Cancel(info->stallEvent);
+        info->stallEvent = Simulator::Schedule(GetStallTimeout(), &ChordApplication::HandleLookupStall, this, msg.nonce);
+    }
+
+    // La richiesta ricorsiva non avanza: l'origine prosegue in modo iterativo a partire dall'ultimo
+    // hop che ha notificato l'avanzamento; una risposta ricorsiva in ritardo chiude comunque il lookup
+    void HandleLookupStall(uint32_t nonce) {
+        LookupInfo* info = pendingLookups.Find(nonce);
+        if (!info || info->iterative || !isAlive) {
+            return;
+        }
+        NS_LOG_INFO("Il lookup " << info->lookupId << " del nodo " << chordId << " non avanza, prosegue in modo iterativo");
+        messageCounters[ChordMessage::LOOKUP_PROGRESS].timeouts++;
+        info->iterative = true;
+        if (info->hasProgress) {
+            AddCandidates(*info, std::vector<ChordId>(1, info->progressNode), info->progressDepth, false);
+        }
+        bool owner = false;
+        std::vector<ChordId> nodes = GetNextHopCandidates(info->fileId, alpha + 1, owner);
+        AddCandidates(*info, nodes, 0, owner);
+        IssueNextHopQueries(nonce);
+    }
+
+    // Attesa massima tra due notifiche di avanzamento: il tempo per reinstradare un hop guasto
+    Time GetStallTimeout() const {
+        return Seconds(2 * (hopTimeout > 0 ? hopTimeout : DEFAULT_HOP_TIMEOUT));
+    }
+
+    bool IsSuspected(ChordId nodeId) const {
+        return suspectedNodes.count(nodeId) > 0;
+    }
+
+    // Proximity route selection: tra i finger e i successori che precedono il target sceglie quello
+    // che minimizza l'RTT verso di lui più gli hop che restano da lì (metà del logaritmo dei nodi
+    // rimanenti, come in Chord) pesati per l'RTT medio dei vicini
+    ChordId SelectProximateHop(ChordId targetId, ChordId best) {
+        if (rttEstimates.empty()) {
+            return best;
+        }
+        double meanRtt = 0;
+        for (const auto& entry : rttEstimates) {
+            meanRtt += entry.second.srtt;
+        }
+        meanRtt /= rttEstimates.size();
+        double density = EstimateDensity();
+
+        auto cost = [&](ChordId id) {
+            auto it = rttEstimates.find(id);
+            double rtt = it != rttEstimates.end() ? it->second.srtt : meanRtt;
+            double remainingHops = 0.5 * std::log2(1.0 + IdToDouble(RingDistance(id, targetId)) * density);
+            return rtt + remainingHops * meanRtt;
+        };
+        double bestCost = cost(best);
+        auto consider = [&](ChordId id) {
+            if (id == chordId || id == best || IsSuspected(id) || !IsInRange(id, chordId, targetId)) {
+                return;
+            }
+            double candidateCost = cost(id);
+            if (candidateCost < bestCost) {
+                best = id;
+                bestCost = candidateCost;
+            }
+        };
+        for (ChordId id : fingerTable) {
+            consider(id);
+        }
+        for (ChordId id : successorList) {
+            consider(id);
+        }
+        return best;
+    }
+
+    // Nodi per identificatore, stimati dall'ampiezza della successor list
+    double EstimateDensity() const {
+        if (successorList.empty()) {
+            return 0.0;
+        }
+        double span = IdToDouble(RingDistance(chordId, successorList.back()));
+        return span > 0 ? successorList.size() / span : 0.0;
+    }
+
+    // Con PNS fix_fingers conserva il finger attuale se è ancora nel suo intervallo ed è più vicino
+    // nell'underlay del successore esatto appena trovato
+    bool KeepProximateFinger(uint32_t index, ChordId successor) const {
+        ChordId current = fingerTable[index];
+        if (pnsCandidates <= 1 || current == chordId || IsSuspected(current)
+            || RingDistance(GetFingerStart(index), current) >= IdPow2(index)) {
+            return false;
+        }
+        auto currentRtt = rttEstimates.find(current);
+        if (currentRtt == rttEstimates.end()) {
+            return false;
+        }
+        auto successorRtt = rttEstimates.find(successor);
+        return successorRtt == rttEstimates.end() || currentRtt->second.srtt < successorRtt->second.srtt;
+    }
+
+    // Senza successori vivi il nodo resterebbe fuori dall'anello: riparte dal finger vivo più vicino
+    // in senso orario o, in mancanza, dal predecessore; la stabilizzazione ricostruisce il resto
+    void RefillSuccessorList() {
+        if (GetLiveSuccessor() != chordId) {
+            return;
+        }
+        ChordId closest = chordId;
+        for (ChordId id : fingerTable) {
+            if (id != chordId && !IsSuspected(id)
+                && (closest == chordId || RingDistance(chordId, id) < RingDistance(chordId, closest))) {
+                closest = id;
+            }
+        }
+        if (closest == chordId && hasPredecessor && predecessor != chordId && !IsSuspected(predecessor)) {
+            closest = predecessor;
+        }
+        if (closest != chordId) {
+            NS_LOG_INFO("Il nodo " << chordId << " non ha più successori vivi, riparte da " << closest);
+            successorList.insert(successorList.begin(), closest);
+        }
+    }
+
+    // Primo successore non sospettato, o il nodo stesso se non ce ne sono
+    ChordId GetLiveSuccessor() const {
+        for (ChordId id : successorList) {
+            if (id != chordId && !IsSuspected(id)) {
+                return id;
+            }
+        }
+        return chordId;
+    }
+
+    void UpdateRtt(ChordId nodeId, Time sample) {
+        double rtt = sample.GetSeconds();
+        auto it = rttEstimates.find(nodeId);
+        if (it == rttEstimates.end()) {
+            rttEstimates[nodeId] = {rtt, rtt / 2};
+            return;
+        }
+        RttEstimate& estimate = it->second;
+        estimate.rttvar = 0.75 * estimate.rttvar + 0.25 * std::fabs(estimate.srtt - rtt);
+        estimate.srtt = 0.875 * estimate.srtt + 0.125 * rtt;
+    }
+
+    // Timeout del singolo hop: hopTimeout finché non c'è un campione di RTT verso il vicino
+    Time GetHopTimeout(ChordId nodeId) const {
+        auto it = rttEstimates.find(nodeId);
+        if (it == rttEstimates.end()) {
+            return Seconds(hopTimeout > 0 ? hopTimeout : DEFAULT_HOP_TIMEOUT);
+        }
+        const RttEstimate& estimate = it->second;
+        double rto = std::max(estimate.srtt + 4 * estimate.rttvar, 1.5 * estimate.srtt);
+        return Seconds(std::max(rto, 0.001));
+    }
+
+    // Invia un messaggio di manutenzione conteggiandolo nel traffico di controllo
+    void SendControlMessage(const ChordMessage& msg, const Address& address) {
+        Ptr<Packet> packet = CreateMessagePacket(msg);
+        if (isAlive && socket) {
+            controlMessages++;
+            controlBytes += packet->GetSize() + UDP_IP_OVERHEAD;
+        }
+        SendMessage(packet, address);
+    }
+
+    bool SendControlMessage(const ChordMessage& msg, ChordId nodeId) {
+        Address address;
+        if (!ResolveAddress(nodeId, address)) {
+            NS_LOG_ERROR("Impossibile trovare l'indirizzo per il nodo " << nodeId);
+            return false;
+        }
+        SendControlMessage(msg, address);
+        return true;
+    }
+
+    // stabilize: se il successore non ha risposto al round precedente viene scartato,
+    // poi si chiede al primo successore vivo il suo predecessore e la sua successor list
+    void Stabilize() {
+        if (!isAlive) {
+            return;
+        }
+        stabilizeEvent = Simulator::Schedule(Seconds(stabilizePeriod), &ChordApplication::Stabilize, this);
+
+        if (stabilizePending) {
+            NS_LOG_INFO("Il nodo " << chordId << " non ha ricevuto risposta dal successore " << stabilizeTarget
+                        << ", lo rimuove dalla successor list");
+            messageCounters[ChordMessage::STABILIZE].timeouts++;
+            suspectedNodes.insert(stabilizeTarget);
+            locationCache.EraseNode(stabilizeTarget);
+            successorList.erase(std::remove(successorList.begin(), successorList.end(), stabilizeTarget),
+                                successorList.end());
+            stabilizePending = false;
+            RefillSuccessorList();
+        }
+
+        ChordId successor = GetLiveSuccessor();
+        if (successor == chordId) {
+            return;
+        }
+
+        ChordMessage msg;
+        msg.type = ChordMessage::STABILIZE;
+        msg.senderId = chordId;
+        msg.originId = chordId;
+        msg.targetId = successor;
+        if (SendControlMessage(msg, successor)) {
+            stabilizePending = true;
+            stabilizeTarget = successor;
+        }
+    }
+
+    void HandleStabilize(const ChordMessage& msg, const Address& from) {
+        ChordMessage reply;
+        reply.type = ChordMessage::STABILIZE_REPLY;
+        reply.senderId = chordId;
+        reply.originId = msg.senderId;
+        reply.targetId = msg.senderId;
+        if (hasPredecessor) {
+            reply.options |= ChordMessage::OPT_PREDECESSOR;
+            reply.predecessorId = predecessor;
+        }
+        reply.options |= ChordMessage::OPT_SUCCESSOR_LIST;
+        reply.successors = successorList;
+        SendControlMessage(reply, from);
+    }
+
+    void HandleStabilizeReply(const ChordMessage& msg) {
+        if (!stabilizePending || msg.senderId != stabilizeTarget) {
+            return;
+        }
+        stabilizePending = false;
+
+        // La successor list è il successore seguito dalla sua lista, troncata a successorListSize
+        std::vector<ChordId> updated;
+        updated.push_back(msg.senderId);
+        for (ChordId id : msg.successors) {
+            if (updated.size() >= successorListSize) {
+                break;
+            }
+            if (id != chordId && std::find(updated.begin(), updated.end(), id) == updated.end()) {
+                updated.push_back(id);
+            }
+        }
+
+        // Il predecessore del successore è un successore migliore se cade tra noi e lui
+        if (msg.HasOption(ChordMessage::OPT_PREDECESSOR)) {
+            ChordId candidate = msg.predecessorId;
+            if (candidate != chordId && candidate != msg.senderId && !IsSuspected(candidate)
+                && IsInRange(candidate, chordId, msg.senderId)) {
+                NS_LOG_INFO("Il nodo " << chordId << " adotta " << candidate << " come nuovo successore");
+                updated.insert(updated.begin(), candidate);
+                updated.erase(std::remove(updated.begin() + 1, updated.end(), candidate), updated.end());
+                if (updated.size() > successorListSize) {
+                    updated.resize(successorListSize);
+                }
+            }
+        }
+
+        successorList = updated;
+        for (ChordId id : successorList) {
+            LearnAddress(id);
+        }
+        if (!fingerTable.empty()) {
+            fingerTable[0] = successorList[0];
+            flatFingers.Build(chordId, fingerTable, m);
+        }
+
+        ChordMessage notify;
+        notify.type = ChordMessage::NOTIFY;
+        notify.senderId = chordId;
+        notify.originId = chordId;
+        notify.targetId = successorList[0];
+        SendControlMessage(notify, successorList[0]);
+    }
+
+    void HandleNotify(const ChordMessage& msg) {
+        ChordId candidate = msg.senderId;
+        if (candidate == chordId) {
+            return;
+        }
+        if (!hasPredecessor || IsInRange(candidate, predecessor, chordId)) {
+            if (!hasPredecessor || candidate != predecessor) {
+                NS_LOG_INFO("Il nodo " << chordId << " adotta " << candidate << " come nuovo predecessore");
+            }
+            predecessor = candidate;
+            hasPredecessor = true;
+            LearnAddress(candidate);
+        }
+    }
+
+    // fix_fingers: aggiorna un finger per round con una FIND_SUCCESSOR instradata sull'anello
+    void FixFingers() {
+        if (!isAlive) {
+            return;
+        }
+        fixFingersEvent = Simulator::Schedule(Seconds(fixFingersPeriod), &ChordApplication::FixFingers, this);
+        if (fingerTable.empty()) {
+            return;
+        }
+
+        nextFinger = (nextFinger + 1) % fingerTable.size();
+        ChordId fingerStart = GetFingerStart(nextFinger);
+
+        ChordId successor = GetLiveSuccessor();
+        if (successor != chordId && IsInRange(fingerStart, chordId, successor)) {
+            fingerTable[nextFinger] = successor;
+            flatFingers.Build(chordId, fingerTable, m);
+            return;
+        }
+
+        ChordId nextHop = FindNextHop(fingerStart);
+        if (nextHop == chordId) {
+            return;
+        }
+
+        SendFindSuccessor(fingerStart, nextHop);
+    }
+
+    // Il primo round di ogni protocollo parte in un istante casuale del periodo, così
+    // i nodi non si sincronizzano
+    void StartMaintenance() {
+        Ptr<UniformRandomVariable> jitter = CreateObject<UniformRandomVariable>();
+        if (stabilizePeriod > 0) {
+            stabilizeEvent = Simulator::Schedule(Seconds(jitter->GetValue(0, stabilizePeriod)),
+                                                 &ChordApplication::Stabilize, this);
+        }
+        if (fixFingersPeriod > 0) {
+            fixFingersEvent = Simulator::Schedule(Seconds(jitter->GetValue(0, fixFingersPeriod)),
+                                                  &ChordApplication::FixFingers, this);
+        }
+        if (checkPredecessorPeriod > 0) {
+            checkPredecessorEvent = Simulator::Schedule(Seconds(jitter->GetValue(0, checkPredecessorPeriod)),
+                                                        &ChordApplication::CheckPredecessor, this);
+        }
+    }
+
+    void StopMaintenance() {
+        Simulator::Cancel(stabilizeEvent);
+        Simulator::Cancel(fixFingersEvent);
+        Simulator::Cancel(checkPredecessorEvent);
+        Simulator::Cancel(joinTimeoutEvent);
+        joining = false;
+    }
+
+    ChordId GetFingerStart(uint32_t index) const {
+        return IdAdd(chordId, IdPow2(index), m);
+    }
+
+    // La risposta torna direttamente a questo nodo e viene associata al finger tramite targetId
+    bool SendFindSuccessor(ChordId targetId, ChordId nextHop) {
+        ChordMessage msg;
+        msg.type = ChordMessage::FIND_SUCCESSOR;
+        msg.senderId = chordId;
+        msg.originId = chordId;
+        msg.targetId = targetId;
+        msg.options |= ChordMessage::OPT_NONCE;
+        msg.nonce = nextControlNonce++;
+        return SendControlMessage(msg, nextHop);
+    }
+
+    void HandleFindSuccessor(const ChordMessage& msg) {
+        if (msg.hopCount > MAX_LOOKUP_HOPS) {
+            NS_LOG_WARN("FIND_SUCCESSOR per " << msg.targetId << " scartata dopo " << msg.hopCount << " hop");
+            return;
+        }
+
+        ChordId successor = GetLiveSuccessor();
+        ChordId result = chordId;
+        bool resolved = successor == chordId || msg.targetId == chordId;
+        if (!resolved && IsInRange(msg.targetId, chordId, successor)) {
+            result = successor;
+            resolved = true;
+        }
+
+        if (!resolved) {
+            ChordId nextHop = FindNextHop(msg.targetId);
+            if (nextHop != chordId) {
+                ChordMessage forward = msg;
+                forward.senderId = chordId;
+                forward.hopCount++;
+                messageCounters[ChordMessage::FIND_SUCCESSOR].forwarded++;
+                SendControlMessage(forward, nextHop);
+                return;
+            }
+        }
+
+        ChordMessage reply;
+        reply.type = ChordMessage::FIND_SUCCESSOR_REPLY;
+        reply.senderId = chordId;
+        reply.originId = msg.originId;
+        reply.targetId = msg.targetId;
+        reply.hopCount = msg.hopCount + 1;
+        reply.options = ChordMessage::OPT_NONCE | ChordMessage::OPT_SUCCESSOR;
+        reply.nonce = msg.nonce;
+        reply.successorId = result;
+        SendControlMessage(reply, msg.originId);
+    }
+
+    void HandleFindSuccessorReply(const ChordMessage& msg) {
+        if (msg.originId != chordId) {
+            return;
+        }
+        if (joining && msg.targetId == chordId) {
+            SendJoinRequest(msg.successorId);
+            return;
+        }
+        if (msg.successorId == chordId) {
+            return;
+        }
+        bool changed = false;
+        for (uint32_t i = 0; i < fingerTable.size(); i++) {
+            if (GetFingerStart(i) == msg.targetId && fingerTable[i] != msg.successorId) {
+                if (KeepProximateFinger(i, msg.successorId)) {
+                    continue;
+                }
+                NS_LOG_LOGIC("Il nodo " << chordId << " aggiorna il finger " << i
+                             << ": " << fingerTable[i] << " -> " << msg.successorId);
+                fingerTable[i] = msg.successorId;
+                changed = true;
+            }
+        }
+        if (changed) {
+            flatFingers.Build(chordId, fingerTable, m);
+            LearnAddress(msg.successorId);
+        }
+    }
+
+    // Primo passo dell'ingresso: FIND_SUCCESSOR del proprio ID tramite il bootstrap
+    void SendJoinLookup() {
+        joinAttempts++;
+        Simulator::Cancel(joinTimeoutEvent);
+        joinTimeoutEvent = Simulator::Schedule(Seconds(JOIN_RETRY_INTERVAL), &ChordApplication::HandleJoinTimeout, this);
+        SendFindSuccessor(chordId, bootstrapId);
+    }
+
+    void SendJoinRequest(ChordId successor) {
+        Simulator::Cancel(joinTimeoutEvent);
+        joinTimeoutEvent = Simulator::Schedule(Seconds(JOIN_RETRY_INTERVAL), &ChordApplication::HandleJoinTimeout, this);
+
+        ChordMessage msg;
+        msg.type = ChordMessage::JOIN;
+        msg.senderId = chordId;
+        msg.originId = chordId;
+        msg.targetId = successor;
+        SendControlMessage(msg, successor);
+    }
+
+    void HandleJoinTimeout() {
+        if (!joining) {
+            return;
+        }
+        messageCounters[ChordMessage::JOIN].timeouts++;
+        if (joinAttempts >= MAX_JOIN_ATTEMPTS) {
+            FinishJoin(false);
+            return;
+        }
+        NS_LOG_INFO("Il nodo " << chordId << " ritenta l'ingresso (tentativo " << joinAttempts + 1 << ")");
+        SendJoinLookup();
+    }
+
+    void FinishJoin(bool success) {
+        Simulator::Cancel(joinTimeoutEvent);
+        joining = false;
+        Time latency = Simulator::Now() - joinStartTime;
+        NS_LOG_INFO("Il nodo " << chordId << (success ? " è entrato" : " non è riuscito a entrare")
+                    << " nell'anello in " << latency.GetMilliSeconds() << "ms");
+        if (!joinCallback.IsNull()) {
+            joinCallback(chordId, latency, success);
+        }
+    }
+
+    // Il successore accetta il nuovo nodo se cade tra il suo predecessore e se stesso, gli cede
+    // le chiavi di quell'intervallo e lo adotta come predecessore; altrimenti lo rimanda al
+    // proprio predecessore, più vicino al punto di ingresso (ingressi concorrenti)
+    void HandleJoin(const ChordMessage& msg, const Address& from) {
+        ChordId joiner = msg.senderId;
+
+        ChordMessage reply;
+        reply.type = ChordMessage::JOIN_REPLY;
+        reply.senderId = chordId;
+        reply.originId = joiner;
+        reply.targetId = joiner;
+
+        if (hasPredecessor && !IsInRange(joiner, predecessor, chordId)) {
+            NS_LOG_INFO("Il nodo " << chordId << " rimanda il nodo " << joiner << " al predecessore " << predecessor);
+            reply.success = false;
+            reply.options |= ChordMessage::OPT_SUCCESSOR;
+            reply.successorId = predecessor;
+            SendControlMessage(reply, from);
+            return;
+        }
+
+        ChordId rangeStart = hasPredecessor ? predecessor : chordId;
+        std::vector<ChordId> moved;
+        for (ChordId key : storedFiles) {
+            if (IsInRange(key, rangeStart, joiner)) {
+                moved.push_back(key);
+            }
+        }
+        // Con la replica il successore resta la prima replica delle chiavi cedute
+        if (replicas <= 1) {
+            for (ChordId key : moved) {
+                storedFiles.erase(key);
+            }
+        }
+        for (size_t i = 0; i < moved.size(); i += KEY_BATCH_SIZE) {
+            ChordMessage transfer;
+            transfer.type = ChordMessage::KEY_TRANSFER;
+            transfer.senderId = chordId;
+            transfer.originId = joiner;
+            transfer.targetId = joiner;
+            transfer.options |= ChordMessage::OPT_KEY_LIST;
+            transfer.keys.assign(moved.begin() + i, moved.begin() + std::min(moved.size(), i + KEY_BATCH_SIZE));
+            Ptr<Packet> packet = CreateMessagePacket(transfer);
+            keyTransferBytes += packet->GetSize() + UDP_IP_OVERHEAD;
+            SendMessage(packet, from);
+        }
+        keysTransferred += moved.size();
+        NS_LOG_INFO("Il nodo " << chordId << " accetta il nodo " << joiner << " come predecessore e gli cede "
+                    << moved.size() << " chiavi");
+
+        // Le chiavi precedono la risposta: alla JOIN_REPLY il nuovo nodo è già responsabile
+        reply.success = true;
+        reply.options |= ChordMessage::OPT_PREDECESSOR | ChordMessage::OPT_SUCCESSOR_LIST;
+        reply.predecessorId = rangeStart;
+        reply.successors = successorList;
+        SendControlMessage(reply, from);
+
+        predecessor = joiner;
+        hasPredecessor = true;
+        pingPending = false;
+        LearnAddress(joiner);
+        if (GetLiveSuccessor() == chordId) {
+            // Anello di un solo nodo: il nuovo nodo è anche il successore
+            successorList.assign(1, joiner);
+            if (!fingerTable.empty()) {
+                fingerTable[0] = joiner;
+                flatFingers.Build(chordId, fingerTable, m);
+            }
+        }
+    }
+
+    void HandleJoinReply(const ChordMessage& msg) {
+        if (!joining) {
+            return;
+        }
+        if (!msg.success) {
+            if (joinAttempts >= MAX_JOIN_ATTEMPTS) {
+                FinishJoin(false);
+                return;
+            }
+            joinAttempts++;
+            SendJoinRequest(msg.successorId);
+            return;
+        }
+
+        successorList.assign(1, msg.senderId);
+        for (ChordId id : msg.successors) {
+            if (successorList.size() >= successorListSize) {
+                break;
+            }
+            if (id != chordId && std::find(successorList.begin(), successorList.end(), id) == successorList.end()) {
+                successorList.push_back(id);
+            }
+        }
+        // Se il successore era solo nell'anello è anche il nostro predecessore
+        predecessor = msg.predecessorId;
+        hasPredecessor = true;
+        fingerTable.assign(m, msg.senderId);
+        flatFingers.Build(chordId, fingerTable, m);
+        for (ChordId id : successorList) {
+            LearnAddress(id);
+        }
+        LearnAddress(predecessor);
+        FinishJoin(true);
+
+        // init_finger_table: una FIND_SUCCESSOR per ogni finger che non cade già nel successore
+        for (uint32_t i = 1; i < fingerTable.size(); i++) {
+            ChordId fingerStart = GetFingerStart(i);
+            if (!IsInRange(fingerStart, chordId, msg.senderId)) {
+                SendFindSuccessor(fingerStart, msg.senderId);
+            }
+        }
+    }
+
+    void HandleKeyTransfer(const ChordMessage& msg) {
+        storedFiles.insert(msg.keys.begin(), msg.keys.end());
+        NS_LOG_LOGIC("Node " << chordId << " ha ricevuto " << msg.keys.size() << " chiavi dal nodo " << msg.senderId);
+    }
+
+    // check_predecessor: un predecessore che non ha risposto al PING del round precedente
+    // viene dimenticato, e sarà sostituito dal prossimo NOTIFY
+    void CheckPredecessor() {
+        if (!isAlive) {
+            return;
+        }
+        checkPredecessorEvent = Simulator::Schedule(Seconds(checkPredecessorPeriod),
+                                                    &ChordApplication::CheckPredecessor, this);
+        if (pingPending) {
+            NS_LOG_INFO("Il nodo " << chordId << " considera guasto il predecessore " << predecessor);
+            messageCounters[ChordMessage::PING].timeouts++;
+            hasPredecessor = false;
+            pingPending = false;
+        }
+        if (!hasPredecessor) {
+            return;
+        }
+
+        ChordMessage ping;
+        ping.type = ChordMessage::PING;
+        ping.senderId = chordId;
+        ping.originId = chordId;
+        ping.targetId = predecessor;
+        pingPending = SendControlMessage(ping, predecessor);
+    }
+
+    void HandlePing(const ChordMessage& msg, const Address& from) {
+        ChordMessage pong;
+        pong.type = ChordMessage::PONG;
+        pong.senderId = chordId;
+        pong.originId = msg.senderId;
+        pong.targetId = msg.senderId;
+        SendControlMessage(pong, from);
+    }
+
+    void HandlePong(const ChordMessage& msg) {
+        if (hasPredecessor && msg.senderId == predecessor) {
+            pingPending = false;
+        }
+    }
+
+    // Memorizza in locale l'indirizzo di un vicino (finger, successore o predecessore)
+    void LearnAddress(ChordId nodeId) {
+        Address address;
+        if (nodeId != chordId && directory && directory->Lookup(nodeId, address)) {
+            nodeAddresses[nodeId] = address;
+        }
+    }
+
+    // Cerca prima tra i vicini noti; per gli altri nodi (ad es. l'origine di un lookup, il cui
+    // indirizzo in Chord viaggerebbe nella richiesta) consulta la directory senza memorizzarlo
+    bool ResolveAddress(ChordId nodeId, Address& address) const {
+        auto it = nodeAddresses.find(nodeId);
+        if (it != nodeAddresses.end()) {
+            address = it->second;
+            return true;
+        }
+        return directory && directory->Lookup(nodeId, address);
+    }
+
+    bool IsInRange(ChordId id, ChordId start, ChordId end) {
+        return IsInRingRange(id, start, end);
+    }
+
+    std::string DescribeMessage(const ChordMessage& msg) {
+        std::ostringstream os;
+        os << GetMessageTypeName(msg.type) << " [targetId: " << msg.targetId << ", hops: " << msg.hopCount << "]";
+        return os.str();
+    }
+
+    // Decodifica il pacchetto solo per il log: non viene chiamata se il livello INFO è disattivato
+    std::string DescribePacket(Ptr<Packet> packet) {
+        ChordHeader header;
+        packet->PeekHeader(header);
+        return DescribeMessage(header.GetMessage());
+    }
+};
+
+uint32_t ChordApplication::nextLookupId = 0;
+
+// Underlay prodotto da un generatore di topologia: collegamenti punto-punto e segmenti CSMA,
+// ognuno con il proprio ritardo (secondi) e la propria banda (bit/s)
+struct UnderlayTopology {
+    struct Link {
+        uint32_t a;
+        uint32_t b;
+        double delay;
+        uint64_t rate;
+    };
+    struct Lan {
+        std::vector<uint32_t> members;
+        double delay;
+        uint64_t rate;
+    };
+
+    uint32_t numNodes;
+    std::vector<Link> links;
+    std::vector<Lan> lans;
+    // Vicini di ogni nodo con il ritardo verso di essi; i segmenti CSMA collegano ogni coppia di membri
+    std::vector<std::vector<std::pair<uint32_t, double>>> adjacency;
+
+    UnderlayTopology() : numNodes(0) {}
+
+    void BuildAdjacency() {
+        adjacency.assign(numNodes, std::vector<std::pair<uint32_t, double>>());
+        for (const Link& link : links) {
+            adjacency[link.a].push_back(std::make_pair(link.b, link.delay));
+            adjacency[link.b].push_back(std::make_pair(link.a, link.delay));
+        }
+        for (const Lan& lan : lans) {
+            for (uint32_t a : lan.members) {
+                for (uint32_t b : lan.members) {
+                    if (a != b) {
+                        adjacency[a].push_back(std::make_pair(b, lan.delay));
+                    }
+                }
+            }
+        }
+    }
+
+    // Ritardo di propagazione minimo da source verso ogni nodo (-1 se irraggiungibile)
+    void ShortestDelays(uint32_t source, std::vector<double>& delay) const {
+        delay.assign(numNodes, -1.0);
+        std::priority_queue<std::pair<double, uint32_t>, std::vector<std::pair<double, uint32_t>>,
+                            std::greater<std::pair<double, uint32_t>>> queue;
+        delay[source] = 0.0;
+        queue.push(std::make_pair(0.0, source));
+        while (!queue.empty()) {
+            std::pair<double, uint32_t> top = queue.top();
+            queue.pop();
+            if (top.first > delay[top.second]) {
+                continue;
+            }
+            for (const auto& edge : adjacency[top.second]) {
+                double candidate = top.first + edge.second;
+                if (delay[edge.first] < 0 || candidate < delay[edge.first]) {
+                    delay[edge.first] = candidate;
+                    queue.push(std::make_pair(candidate, edge.first));
+                }
+            }
+        }
+    }
+
+    // Ritardo di propagazione da source verso ogni nodo lungo un percorso con meno hop, come quelli
+    // scelti dal routing nix-vector (-1 se irraggiungibile)
+    void FewestHopDelays(uint32_t source, std::vector<double>& delay) const {
+        delay.assign(numNodes, -1.0);
+        std::queue<uint32_t> queue;
+        delay[source] = 0.0;
+        queue.push(source);
+        while (!queue.empty()) {
+            uint32_t current = queue.front();
+            queue.pop();
+            for (const auto& edge : adjacency[current]) {
+                if (delay[edge.first] < 0) {
+                    delay[edge.first] = delay[current] + edge.second;
+                    queue.push(edge.first);
+                }
+            }
+        }
+    }
+};
+
+// Generatori dell'underlay. Tutti usano memoria proporzionale al numero di collegamenti e traggono
+// ritardi e bande da --link-delay e --link-rate, scalati per classe di collegamento dove serve
+class TopologyGenerator {
+private:
+    static void AddLink(UnderlayTopology& topology, uint32_t a, uint32_t b, double delay, uint64_t rate) {
+        topology.links.push_back({a, b, delay, rate});
+    }
+
+    // Generatore originale: anello dei primi 10 nodi, poi ogni nodo si collega a 3 nodi distinti
+    // estratti da una finestra di indici precedenti
+    static void Window(UnderlayTopology& topology, Ptr<UniformRandomVariable> rng, double delay, uint64_t rate) {
+        uint32_t n = topology.numNodes;
+        const uint32_t ringSize = std::min(n, (uint32_t)10);
+        for (uint32_t i = 0; i < ringSize; i++) {
+            AddLink(topology, i, (i + 1) % ringSize, delay, rate);
+        }
+        for (uint32_t i = ringSize; i < n; i++) {
+            uint32_t linked[3];
+            uint32_t numLinks = 0;
+            while (numLinks < 3) {
+                uint32_t j = rng->GetInteger((i - ringSize) / 3 * 2, i - 1);
+                if (std::find(linked, linked + numLinks, j) != linked + numLinks) {
+                    continue;
+                }
+                linked[numLinks++] = j;
+                AddLink(topology, i, j, delay, rate);
+            }
+        }
+    }
+
+    // Barabási–Albert: i primi links+1 nodi formano una clique, ogni nodo successivo si collega a
+    // links nodi distinti scelti con probabilità proporzionale al grado (estrazione uniforme dalla
+    // lista degli estremi dei collegamenti)
+    static void PreferentialAttachment(UnderlayTopology& topology, const std::vector<uint32_t>& members,
+                                       uint32_t links, Ptr<UniformRandomVariable> rng, double delay, uint64_t rate) {
+        std::vector<uint32_t> endpoints;
+        uint32_t core = std::min<uint32_t>(members.size(), links + 1);
+        for (uint32_t i = 0; i < core; i++) {
+            for (uint32_t j = 0; j < i; j++) {
+                AddLink(topology, members[i], members[j], delay, rate);
+                endpoints.push_back(members[i]);
+                endpoints.push_back(members[j]);
+            }
+        }
+        std::vector<uint32_t> targets;
+        for (uint32_t i = core; i < members.size(); i++) {
+            targets.clear();
+            while (targets.size() < links) {
+                uint32_t target = endpoints[rng->GetInteger(0, endpoints.size() - 1)];
+                if (std::find(targets.begin(), targets.end(), target) == targets.end()) {
+                    targets.push_back(target);
+                }
+            }
+            for (uint32_t target : targets) {
+                AddLink(topology, members[i], target, delay, rate);
+                endpoints.push_back(members[i]);
+                endpoints.push_back(target);
+            }
+        }
+    }
+
+    // Transit-stub: i primi transit nodi formano il nucleo (anello più una corda casuale per nodo),
+    // gli altri sono divisi in domini stub di domainSize nodi contigui, ciascuno ad anello e collegato
+    // al nucleo dal suo primo nodo. Nucleo: ritardo pieno e banda x10; accesso: metà ritardo;
+    // collegamenti interni agli stub: un decimo del ritardo
+    static void TransitStub(UnderlayTopology& topology, uint32_t transit, uint32_t domainSize,
+                            Ptr<UniformRandomVariable> rng, double delay, uint64_t rate) {
+        uint32_t n = topology.numNodes;
+        for (uint32_t i = 0; i < transit; i++) {
+            uint32_t next = (i + 1) % transit;
+            if (next != i && (transit > 2 || i == 0)) {
+                AddLink(topology, i, next, delay, rate * 10);
+            }
+        }
+        if (transit > 3) {
+            for (uint32_t i = 0; i < transit; i++) {
+                uint32_t j = rng->GetInteger(0, transit - 1);
+                uint32_t distance = std::min((j + transit - i) % transit, (i + transit - j) % transit);
+                if (distance > 1 && i < j) {
+                    AddLink(topology, i, j, delay, rate * 10);
+                }
+            }
+        }
+        for (uint32_t start = transit; start < n; start += domainSize) {
+            uint32_t end = std::min(n, start + domainSize);
+            AddLink(topology, start, rng->GetInteger(0, transit - 1), delay / 2, rate);
+            for (uint32_t i = start + 1; i < end; i++) {
+                AddLink(topology, i - 1, i, delay / 10, rate);
+            }
+            if (end - start > 2) {
+                AddLink(topology, end - 1, start, delay / 10, rate);
+            }
+        }
+    }
+
+    // Stella di LAN: segmenti CSMA di domainSize nodi contigui (un venticinquesimo del ritardo, banda
+    // x10) i cui primi nodi fanno da router, collegati tra loro con preferential attachment
+    static void StarOfLans(UnderlayTopology& topology, uint32_t domainSize, uint32_t links,
+                           Ptr<UniformRandomVariable> rng, double delay, uint64_t rate) {
+        std::vector<uint32_t> gateways;
+        for (uint32_t start = 0; start < topology.numNodes; start += domainSize) {
+            uint32_t end = std::min(topology.numNodes, start + domainSize);
+            gateways.push_back(start);
+            if (end - start > 1) {
+                UnderlayTopology::Lan lan;
+                for (uint32_t i = start; i < end; i++) {
+                    lan.members.push_back(i);
+                }
+                lan.delay = delay / 25;
+                lan.rate = rate * 10;
+                topology.lans.push_back(lan);
+            }
+        }
+        PreferentialAttachment(topology, gateways, std::min<uint32_t>(links, gateways.size() - 1), rng, delay, rate);
+    }
+
+public:
+    // Banda nella sintassi di DataRate (es. "100Mbps"); falso se non è valida o è nulla, invece
+    // dell'NS_FATAL di DataRate
+    static bool ParseRate(const std::string& text, uint64_t& bitRate) {
+        std::istringstream is(text);
+        DataRate parsed;
+        std::string rest;
+        if (!(is >> parsed) || (is >> rest) || parsed.GetBitRate() == 0) {
+            return false;
+        }
+        bitRate = parsed.GetBitRate();
+        return true;
+    }
+
+    // Lista di collegamenti, una riga "a b [ritardo_ms] [banda]" per collegamento (es. "0 1 20 100Mbps");
+    // righe vuote e commenti "#" ignorati. I nodi sono 0..max, ciascuno con almeno un collegamento
+    static bool LoadEdgeList(const std::string& filename, double delay, uint64_t rate,
+                             UnderlayTopology& topology, std::string& error) {
+        std::ifstream in(filename);
+        if (!in.is_open()) {
+            error = "impossibile aprire la topologia " + filename;
+            return false;
+        }
+        topology = UnderlayTopology();
+        std::string line;
+        uint32_t lineNumber = 0;
+        while (std::getline(in, line)) {
+            lineNumber++;
+            line = line.substr(0, line.find('#'));
+            std::istringstream fields(line);
+            int64_t a;
+            int64_t b;
+            if (!(fields >> a)) {
+                continue;
+            }
+            std::string linkDelayMs;
+            std::string linkRate;
+            std::string extra;
+            double linkDelay = delay;
+            uint64_t linkBitRate = rate;
+            std::string where = filename + ":" + std::to_string(lineNumber) + ": ";
+            if (!(fields >> b) || a < 0 || b < 0 || a == b || a > UINT32_MAX - 1 || b > UINT32_MAX - 1) {
+                error = where + "collegamento non valido";
+                return false;
+            }
+            if (fields >> linkDelayMs) {
+                char* end = nullptr;
+                double value = std::strtod(linkDelayMs.c_str(), &end);
+                if (*end != '\0' || !std::isfinite(value) || value <= 0) {
+                    error = where + "ritardo non valido (" + linkDelayMs + "), serve un numero positivo di ms";
+                    return false;
+                }
+                linkDelay = value / 1000.0;
+            }
+            if ((fields >> linkRate) && !ParseRate(linkRate, linkBitRate)) {
+                error = where + "banda non valida (" + linkRate + ")";
+                return false;
+            }
+            if (fields >> extra) {
+                error = where + "campi in eccesso (" + extra + ")";
+                return false;
+            }
+            AddLink(topology, a, b, linkDelay, linkBitRate);
+            topology.numNodes = std::max<uint32_t>(topology.numNodes, std::max(a, b) + 1);
+        }
+        std::vector<bool> linked(topology.numNodes, false);
+        for (const UnderlayTopology::Link& link : topology.links) {
+            linked[link.a] = true;
+            linked[link.b] = true;
+        }
+        if (topology.links.empty() || std::find(linked.begin(), linked.end(), false) != linked.end()) {
+            error = "la topologia " + filename + " è vuota o ha nodi senza collegamenti";
+            return false;
+        }
+        topology.BuildAdjacency();
+        std::vector<double> reached;
+        topology.ShortestDelays(0, reached);
+        if (std::find(reached.begin(), reached.end(), -1.0) != reached.end()) {
+            error = "la topologia " + filename + " non è connessa";
+            return false;
+        }
+        return true;
+    }
+
+    // Underlay di numNodes nodi secondo config.topology; con "file" il numero di nodi è quello del file
+    static bool Generate(const ChordConfig& config, uint32_t numNodes, Ptr<UniformRandomVariable> rng,
+                         UnderlayTopology& topology, std::string& error) {
+        uint64_t rate = DataRate(config.linkRate).GetBitRate();
+        if (config.topology == "file") {
+            if (!LoadEdgeList(config.topologyFile, config.linkDelay, rate, topology, error)) {
+                return false;
+            }
+        } else {
+            topology = UnderlayTopology();
+            topology.numNodes = numNodes;
+            if (config.topology == "ba") {
+                std::vector<uint32_t> members(numNodes);
+                for (uint32_t i = 0; i < numNodes; i++) {
+                    members[i] = i;
+                }
+                PreferentialAttachment(topology, members, config.baLinks, rng, config.linkDelay, rate);
+            } else if (config.topology == "transit-stub") {
+                uint32_t transit = config.transitNodes > 0 ? config.transitNodes
+                                                           : (numNodes + 4 * config.domainSize - 1) / (4 * config.domainSize);
+                transit = std::max<uint32_t>(1, std::min(transit, numNodes));
+                TransitStub(topology, transit, config.domainSize, rng, config.linkDelay, rate);
+            } else if (config.topology == "lan") {
+                StarOfLans(topology, config.domainSize, config.baLinks, rng, config.linkDelay, rate);
+            } else {
+                Window(topology, rng, config.linkDelay, rate);
+            }
+            topology.BuildAdjacency();
+        }
+        return true;
+    }
+};
+
+// Istantanea binaria dell'anello costruito: nodi (ChordID, predecessore, finger, successori, RTT
+// verso i vicini e chiavi memorizzate), insieme dei file e underlay. Il file è una sequenza di
+// array a larghezza fissa allineati a 8 byte, nell'ordine della macchina che l'ha scritto, e viene
+// letto con mmap senza alcuna conversione
+class RingSnapshot {
+public:
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t m;
+        uint32_t numNodes;
+        uint32_t totalNodes;
+        uint32_t numFiles;
+        uint32_t successorListSize;
+        uint32_t replicas;
+        uint32_t numLinks;
+        uint32_t numLans;
+        uint32_t pnsCandidates;
+        uint32_t proximity;      // RTT verso i vicini salvati (PNS o PRS attivi)
+        uint32_t idBits;         // CHORD_ID_BITS del programma che l'ha scritta
+        uint64_t successors;     // elementi degli array a lunghezza variabile
+        uint64_t rtts;
+        uint64_t storedKeys;
+        uint64_t lanMembers;
+    };
+
+    struct Link {
+        uint32_t a;
+        uint32_t b;
+        double delay;
+        uint64_t rate;
+    };
+
+    // Array del file mappato, validi finché l'istantanea resta aperta
+    const Header* header;
+    const ChordId* ids;
+    const ChordId* predecessors;
+    const ChordId* fingers;             // totalNodes x m
+    const uint32_t* successorOffsets;    // totalNodes + 1, indici in successors
+    const ChordId* successors;
+    const uint32_t* rttOffsets;
+    const ChordId* rttIds;
+    const double* rttValues;
+    const ChordId* files;
+    const uint32_t* storedOffsets;
+    const ChordId* storedKeys;
+    const Link* links;
+    const uint32_t* lanOffsets;          // numLans + 1, indici in lanMembers
+    const uint32_t* lanMembers;
+    const double* lanDelays;
+    const uint64_t* lanRates;
+
+private:
+    static constexpr char MAGIC[8] = {'C', 'H', 'O', 'R', 'D', 'R', 'N', 'G'};
+    static const uint32_t VERSION = 2;
+
+    void* mapping;
+    size_t mappingSize;
+    size_t cursor;
+
+    static size_t Align(size_t size) {
+        return (size + 7) & ~(size_t)7;
+    }
+
+    template <typename T>
+    bool Take(const T*& array, uint64_t count) {
+        size_t bytes = Align(count * sizeof(T));
+        if (cursor + bytes > mappingSize) {
+            return false;
+        }
+        array = reinterpret_cast<const T*>(static_cast<const char*>(mapping) + cursor);
+        cursor += bytes;
+        return true;
+    }
+
+    // Offset di un array a lunghezza variabile: non decrescenti ed entro i count elementi
+    static bool ValidOffsets(const uint32_t* offsets, uint64_t entries, uint64_t count) {
+        for (uint64_t i = 0; i < entries; i++) {
+            if (offsets[i] > offsets[i + 1]) {
+                return false;
+            }
+        }
+        return offsets[entries] <= count;
+    }
+
+    // Controlla che gli array rimandino solo a nodi e posizioni esistenti, così un file corrotto
+    // non produce letture fuori dai limiti né ID sconosciuti
+    bool Validate(std::string& error) const {
+        uint64_t n = header->totalNodes;
+        if (!ValidOffsets(successorOffsets, n, header->successors) || !ValidOffsets(rttOffsets, n, header->rtts)
+            || !ValidOffsets(storedOffsets, n, header->storedKeys)
+            || !ValidOffsets(lanOffsets, header->numLans, header->lanMembers)) {
+            error = "offset non validi";
+            return false;
+        }
+        std::unordered_set<ChordId> known(ids, ids + n);
+        if (known.size() != n) {
+            error = "ChordID duplicati";
+            return false;
+        }
+        auto allKnown = [&](const ChordId* array, uint64_t count) {
+            for (uint64_t i = 0; i < count; i++) {
+                if (known.find(array[i]) == known.end()) {
+                    return false;
+                }
+            }
+            return true;
+        };
+        if (!allKnown(predecessors, n) || !allKnown(fingers, n * header->m)
+            || !allKnown(successors, successorOffsets[n])) {
+            error = "riferimenti a ChordID assenti dall'anello";
+            return false;
+        }
+        for (uint32_t i = 0; i < header->numLinks; i++) {
+            if (links[i].a >= n || links[i].b >= n) {
+                error = "collegamenti verso nodi inesistenti";
+                return false;
+            }
+        }
+        for (uint64_t i = 0; i < lanOffsets[header->numLans]; i++) {
+            if (lanMembers[i] >= n) {
+                error = "segmenti CSMA con nodi inesistenti";
+                return false;
+            }
+        }
+        return true;
+    }
+
+    template <typename T>
+    static void Put(std::ofstream& out, const T* array, uint64_t count) {
+        static const char padding[8] = {};
+        size_t bytes = count * sizeof(T);
+        out.write(reinterpret_cast<const char*>(array), bytes);
+        out.write(padding, Align(bytes) - bytes);
+    }
+
+    template <typename T>
+    static void Put(std::ofstream& out, const std::vector<T>& array) {
+        Put(out, array.data(), array.size());
+    }
+
+public:
+    RingSnapshot() : header(nullptr), mapping(nullptr), mappingSize(0), cursor(0) {}
+    RingSnapshot(const RingSnapshot&) = delete;
+    RingSnapshot& operator=(const RingSnapshot&) = delete;
+
+    ~RingSnapshot() {
+        Close();
+    }
+
+    bool Open(const std::string& filename, std::string& error) {
+        Close();
+        int fd = open(filename.c_str(), O_RDONLY);
+        struct stat info;
+        if (fd < 0 || fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(Header)) {
+            error = "impossibile leggere l'istantanea " + filename;
+            if (fd >= 0) {
+                close(fd);
+            }
+            return false;
+        }
+        mappingSize = info.st_size;
+        mapping = mmap(nullptr, mappingSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (mapping == MAP_FAILED) {
+            mapping = nullptr;
+            error = "impossibile mappare l'istantanea " + filename;
+            return false;
+        }
+
+        cursor = 0;
+        Take(header, 1);
+        if (memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0 || header->version != VERSION) {
+            error = filename + " non è un'istantanea dell'anello compatibile";
+            Close();
+            return false;
+        }
+        if (header->idBits != CHORD_ID_BITS) {
+            error = filename + " usa identificatori a " + std::to_string(header->idBits) + " bit, il programma a "
+                    + std::to_string(CHORD_ID_BITS);
+            Close();
+            return false;
+        }
+        uint64_t n = header->totalNodes;
+        bool complete = Take(ids, n) && Take(predecessors, n) && Take(fingers, n * header->m)
+                        && Take(successorOffsets, n + 1) && Take(successors, header->successors)
+                        && Take(rttOffsets, n + 1) && Take(rttIds, header->rtts) && Take(rttValues, header->rtts)
+                        && Take(files, header->numFiles)
+                        && Take(storedOffsets, n + 1) && Take(storedKeys, header->storedKeys)
+                        && Take(links, header->numLinks)
+                        && Take(lanOffsets, header->numLans + 1) && Take(lanMembers, header->lanMembers)
+                        && Take(lanDelays, header->numLans) && Take(lanRates, header->numLans);
+        if (!complete) {
+            error = "l'istantanea " + filename + " è troncata";
+            Close();
+            return false;
+        }
+        std::string reason;
+        if (!Validate(reason)) {
+            error = "l'istantanea " + filename + " è corrotta: " + reason;
+            Close();
+            return false;
+        }
+        return true;
+    }
+
+    void Close() {
+        if (mapping) {
+            munmap(mapping, mappingSize);
+        }
+        mapping = nullptr;
+        header = nullptr;
+    }
+
+    bool IsOpen() const {
+        return header != nullptr;
+    }
+
+    // Vero se l'anello salvato ha gli stessi parametri di quello richiesto
+    bool Matches(const ChordConfig& config, std::string& error) const {
+        if (header->m == config.m && header->numNodes == config.numNodes
+            && header->totalNodes == config.numNodes + config.joiningNodes && header->numFiles == config.numFiles
+            && header->successorListSize == config.successorListSize && header->replicas == config.replicas
+            && header->pnsCandidates == config.pnsCandidates && (header->proximity || !config.prs)) {
+            return true;
+        }
+        std::ostringstream os;
+        os << "l'istantanea è stata costruita con --m=" << header->m << " --nodes=" << header->numNodes
+           << " --joining=" << header->totalNodes - header->numNodes << " --files=" << header->numFiles
+           << " --succ=" << header->successorListSize << " --replicas=" << header->replicas
+           << " --pns=" << header->pnsCandidates << (header->proximity ? "" : " senza RTT per --prs");
+        error = os.str();
+        return false;
+    }
+
+    // Underlay ricostruito dai collegamenti salvati
+    void GetTopology(UnderlayTopology& topology) const {
+        topology = UnderlayTopology();
+        topology.numNodes = header->totalNodes;
+        for (uint32_t i = 0; i < header->numLinks; i++) {
+            topology.links.push_back({links[i].a, links[i].b, links[i].delay, links[i].rate});
+        }
+        for (uint32_t i = 0; i < header->numLans; i++) {
+            UnderlayTopology::Lan lan;
+            lan.members.assign(lanMembers + lanOffsets[i], lanMembers + lanOffsets[i + 1]);
+            lan.delay = lanDelays[i];
+            lan.rate = lanRates[i];
+            topology.lans.push_back(lan);
+        }
+        topology.BuildAdjacency();
+    }
+
+    static bool Write(const std::string& filename, const ChordConfig& config, const std::vector<ChordNode>& nodes,
+                      const std::vector<ChordId>& fileIds, const std::vector<std::vector<ChordId>>& stored,
+                      const UnderlayTopology& topology) {
+        uint32_t m = config.m;
+        std::ofstream out(filename, std::ios::binary);
+        if (!out.is_open()) {
+            return false;
+        }
+        Header h;
+        memset(&h, 0, sizeof(h));
+        memcpy(h.magic, MAGIC, sizeof(MAGIC));
+        h.version = VERSION;
+        h.m = m;
+        h.numNodes = config.numNodes;
+        h.totalNodes = nodes.size();
+        h.numFiles = fileIds.size();
+        h.successorListSize = config.successorListSize;
+        h.replicas = config.replicas;
+        h.pnsCandidates = config.pnsCandidates;
+        h.proximity = config.pnsCandidates > 1 || config.prs;
+        h.numLinks = topology.links.size();
+        h.numLans = topology.lans.size();
+        h.idBits = CHORD_ID_BITS;
+
+        std::vector<ChordId> idArray, predecessorArray, fingerArray, successorArray, rttIdArray, storedArray;
+        std::vector<uint32_t> successorOffsetArray(1, 0), rttOffsetArray(1, 0), storedOffsetArray(1, 0);
+        std::vector<double> rttValueArray;
+        for (uint32_t i = 0; i < nodes.size(); i++) {
+            const ChordNode& node = nodes[i];
+            idArray.push_back(node.chordId);
+            predecessorArray.push_back(node.predecessor);
+            std::vector<ChordId> fingerTable = node.fingerTable;
+            fingerTable.resize(m, node.chordId);
+            fingerArray.insert(fingerArray.end(), fingerTable.begin(), fingerTable.end());
+            successorArray.insert(successorArray.end(), node.successorList.begin(), node.successorList.end());
+            successorOffsetArray.push_back(successorArray.size());
+            for (const auto& entry : node.neighborRtt) {
+                rttIdArray.push_back(entry.first);
+                rttValueArray.push_back(entry.second);
+            }
+            rttOffsetArray.push_back(rttIdArray.size());
+            storedArray.insert(storedArray.end(), stored[i].begin(), stored[i].end());
+            storedOffsetArray.push_back(storedArray.size());
+        }
+        std::vector<Link> linkArray;
+        for (const UnderlayTopology::Link& link : topology.links) {
+            linkArray.push_back({link.a, link.b, link.delay, link.rate});
+        }
+        std::vector<uint32_t> lanOffsetArray(1, 0), lanMemberArray;
+        std::vector<double> lanDelayArray;
+        std::vector<uint64_t> lanRateArray;
+        for (const UnderlayTopology::Lan& lan : topology.lans) {
+            lanMemberArray.insert(lanMemberArray.end(), lan.members.begin(), lan.members.end());
+            lanOffsetArray.push_back(lanMemberArray.size());
+            lanDelayArray.push_back(lan.delay);
+            lanRateArray.push_back(lan.rate);
+        }
+        h.successors = successorArray.size();
+        h.rtts = rttIdArray.size();
+        h.storedKeys = storedArray.size();
+        h.lanMembers = lanMemberArray.size();
+
+        Put(out, &h, 1);
+        Put(out, idArray);
+        Put(out, predecessorArray);
+        Put(out, fingerArray);
+        Put(out, successorOffsetArray);
+        Put(out, successorArray);
+        Put(out, rttOffsetArray);
+        Put(out, rttIdArray);
+        Put(out, rttValueArray);
+        Put(out, fileIds);
+        Put(out, storedOffsetArray);
+        Put(out, storedArray);
+        Put(out, linkArray);
+        Put(out, lanOffsetArray);
+        Put(out, lanMemberArray);
+        Put(out, lanDelayArray);
+        Put(out, lanRateArray);
+        return out.good();
+    }
+};
+
+class ChordNetwork {
+private:
+    friend class ChordBench;
+
+    ChordConfig config;
+    uint32_t m;                      
+    uint32_t numNodes;               
+    uint32_t numFiles;               
+    uint32_t numLookups;          
+    uint32_t failingNodes;           
+    Time timeoutDuration;
+    uint32_t totalNodes;             // nodi iniziali più quelli che entreranno durante la simulazione            
+    bool analytic;                   // motore analitico: nessun nodo ns-3 e nessuna applicazione
+    uint32_t rank;                   // rank MPI di questo processo e numero di rank
+    uint32_t ranks;
+    double wallClock;                // secondi reali impiegati da Simulator::Run
+    
+    std::vector<ChordId> files;
+    std::vector<ChordId> filesForLookup;  
+    std::vector<ChordNode> nodes;    
+    std::unordered_map<ChordId, uint32_t> chordIdToIndex;
+    ChordRing ring;                  
+    Ptr<ChordAddressDirectory> directory;
+    NodeContainer nsNodes;           
+    // Collegamenti fisici prodotti dal generatore, usati anche per stimare gli RTT con PNS/PRS
+    UnderlayTopology underlay;
+    // Istantanea aperta durante la costruzione con --load-ring
+    RingSnapshot snapshot;
+    bool ringRestored;
+    std::vector<Ptr<ChordApplication>> applications;  
+    
+    struct Statistics {
+        uint32_t totalLookups;
+        uint32_t successfulLookups;
+        uint32_t averageHops;
+        uint32_t failedLookups;
+        uint32_t minHops;
+        uint32_t maxHops;
+        uint32_t timedOutLookups;
+        LatencyHistogram latency;             // latenza end-to-end dei lookup riusciti
+        LatencyHistogram failureLatency;      // tempo fino al fallimento (risposta negativa o timeout)
+        LatencyHistogram timeoutLatency;      // tempo fino allo scadere, solo per i lookup scaduti
+        std::vector<uint64_t> hopHistogram;   // lookup riusciti per numero di hop
+        uint32_t joinedNodes;
+        uint32_t failedJoins;
+        LatencyHistogram joinLatency;         // dall'avvio dell'ingresso alla JOIN_REPLY
+        uint32_t churnDepartures;
+        uint32_t churnRejoins;
+
+        Statistics() : totalLookups(0), successfulLookups(0), averageHops(0), failedLookups(0),
+                       minHops(UINT32_MAX), maxHops(0), timedOutLookups(0), joinedNodes(0), failedJoins(0),
+                       churnDepartures(0), churnRejoins(0) {}
+    } stats;
+
+    std::set<uint32_t> processedLookups;
+
+    // Modello di popolarità delle chiavi
+    Ptr<UniformRandomVariable> popularityRng;
+    std::vector<double> zipfCdf;     // distribuzione cumulativa sui ranghi, il rango k è files[k]
+    uint32_t hotKeys;
+    std::vector<ChordId> keyTrace;
+    size_t tracePosition;
+
+    // Stato del generatore di lookup open-loop
+    Ptr<UniformRandomVariable> workloadRng;
+    Ptr<ExponentialRandomVariable> arrivalRng;
+    Time workloadStart;
+    Time measureStart;
+    Time measureEnd;
+    uint32_t firstMeasuredLookupId;
+    uint32_t measuredArrivals;
+    Time joinEnd;                    // istante dell'ultima ondata di ingressi
+
+    // Motore di churn
+    Ptr<ExponentialRandomVariable> churnExp;
+    Ptr<ParetoRandomVariable> churnPareto;
+    Ptr<WeibullRandomVariable> churnWeibull;
+    Ptr<UniformRandomVariable> churnRng;
+    std::vector<bool> rejoining;     // il nodo sta rientrando dopo un'uscita per churn
+
+    // Intervallo corrente della serie temporale: i lookup vengono assegnati all'intervallo
+    // in cui si concludono e ogni riga viene scritta su file appena l'intervallo termina
+    struct TimeSeriesBucket {
+        uint32_t completed;
+        uint32_t successful;
+        uint32_t timedOut;
+        uint32_t departures;
+        uint32_t rejoins;
+        LatencyHistogram latency;
+
+        TimeSeriesBucket() : completed(0), successful(0), timedOut(0), departures(0), rejoins(0) {}
+    } timeSeries;
+    std::ofstream timeSeriesOut;
+    std::ofstream nodeStatsOut;
+
+    // Motore analitico. L'underlay è un grafo di al più ANALYTIC_ROUTERS router prodotto dallo stesso
+    // generatore della rete a pacchetti, con la matrice dei ritardi tra router precalcolata; ogni nodo
+    // oltre i primi è collegato a un router casuale da un ulteriore collegamento di accesso
+    static const uint32_t ANALYTIC_ROUTERS = 2048;
+    uint32_t numRouters;
+    std::vector<float> routerDelay;              // numRouters x numRouters, in secondi
+    std::vector<uint32_t> accessRouter;          // router di ogni nodo
+    std::vector<std::vector<ChordId>> analyticSuspected;   // vicini scoperti guasti da ogni nodo
+    std::vector<FlatFingerTable> analyticFingers;   // finger dei nodi, solo in forma piatta
+    std::vector<uint64_t> analyticHandled;       // richieste ricevute da ogni nodo
+    std::vector<uint64_t> analyticServed;
+
+    // Stato di un lookup del motore analitico, trasportato dagli eventi
+    struct AnalyticLookup {
+        uint32_t lookupId;
+        ChordId fileId;
+        uint32_t origin;        // indice del nodo che ha avviato il lookup
+        Time startTime;
+        uint32_t hopCount;      // come nel campo hopCount di LOOKUP_REQUEST
+        bool owner;             // il destinatario è ritenuto responsabile della chiave
+    };
+
+public:
+    ChordNetwork(const ChordConfig& cfg)
+        : config(cfg)
+        , m(cfg.m)
+        , numNodes(cfg.numNodes)
+        , numFiles(cfg.numFiles)
+        , numLookups(cfg.numLookups)
+        , failingNodes(cfg.failingNodes)
+        , timeoutDuration(cfg.timeout)
+        , totalNodes(cfg.numNodes + cfg.joiningNodes)
+        , analytic(cfg.engine == "analytic")
+        , rank(0)
+        , ranks(1)
+        , wallClock(0.0)
+        , ringRestored(false)
+        , hotKeys(0)
+        , tracePosition(0)
+        , firstMeasuredLookupId(0)
+        , measuredArrivals(0)
+        , numRouters(0) {
+            initializeNetwork();
+    }
+
+    void initializeNetwork() {
+#ifdef NS3_MPI
+        if (config.mpi) {
+            rank = MpiInterface::GetSystemId();
+            ranks = MpiInterface::GetSize();
+        }
+#endif
+        if (!config.loadRing.empty()) {
+            // Compatibilità con i parametri già controllata in main
+            std::string error;
+            ringRestored = snapshot.Open(config.loadRing, error);
+            if (!ringRestored) {
+                cout << "ERRORE: " << error << endl;
+            }
+        }
+        if (analytic) {
+            createOverlayNodes();
+        } else {
+            createPhysicalNetwork();
+        }
+
+        if (ringRestored) {
+            RestoreRing();
+            snapshot.Close();
+            return;
+        }
+        
+        bool proximity = config.pnsCandidates > 1 || config.prs;
+        for (uint32_t i = 0; i < numNodes; i++) {
+            std::vector<double> rtt;
+            if (proximity) {
+                rtt = ComputeUnderlayRtt(i);
+            }
+            initializeFingerTable(i, rtt);
+            initializeSuccessorList(i);
+            if (analytic) {
+                // Con milioni di nodi le finger table non vengono tenute due volte
+                analyticFingers[i].Build(nodes[i].chordId, nodes[i].fingerTable, m);
+                std::vector<ChordId>().swap(nodes[i].fingerTable);
+            }
+            if (proximity) {
+                RecordNeighborRtts(i, rtt);
+            }
+        }
+        // I nodi che entreranno partono isolati: finger verso se stessi e nessun successore
+        for (uint32_t i = numNodes; i < totalNodes; i++) {
+            nodes[i].fingerTable.assign(m, nodes[i].chordId);
+            nodes[i].predecessor = nodes[i].chordId;
+        }
+
+        if (!analytic) {
+            createChordApplications();
+        }
+
+        // Gli ID dei file sono gli hash dei nomi delle chiavi (--keys o file-0, file-1, ...)
+        for (uint32_t i = 0; i < numFiles; i++) {
+            files.push_back(HashKey(config.keyNames.empty() ? "file-" + std::to_string(i) : config.keyNames[i], m));
+        }
+    }
+
+    void StartSimulation() {
+        cout << "Startando la simulazione Chord con " << numNodes << " nodi" << endl;
+        if (ringRestored) {
+            cout << "Fase 1: " << numFiles << " file già memorizzati dall'istantanea" << endl;
+        } else {
+            cout << "Fase 1: Inserimento di " << numFiles << " file" << endl;
+            InsertFiles();
+        }
+
+        cout << "Fase 2: Simulazione di " << failingNodes << " nodi che falliscono" << endl;
+        SimulateNodeFailures();
+
+        if (config.joiningNodes > 0) {
+            cout << "Fase 2b: Ingresso di " << config.joiningNodes << " nodi a ondate di " << config.joinWave
+                 << " ogni " << config.joinInterval << "s da t=" << config.joinStart << "s" << endl;
+            ScheduleJoins();
+        }
+
+        if (config.churn != "none") {
+            cout << "Fase 2c: Churn " << config.churn << " da t=" << config.churnStart << "s (sessione media "
+                 << config.sessionTime << "s, assenza media " << config.downTime << "s)" << endl;
+            StartChurn();
+        }
+
+        if (!config.timeSeriesFile.empty()) {
+            StartTimeSeries();
+        }
+
+        if (!config.nodeStatsFile.empty()) {
+            StartNodeStats();
+        }
+
+        PrepareFilesToLookup();
+
+        cout << "Fase 3: Esecuzione di " << numLookups << " lookup" << endl;
+        PerformLookups();
+    }
+
+    // Raccoglie su tutti i rank le statistiche dei lookup, registrate dal rank del nodo di origine
+    void ReduceStatistics() {
+#ifdef NS3_MPI
+        if (ranks <= 1) {
+            return;
+        }
+        MPI_Comm comm = MpiInterface::GetCommunicator();
+        uint32_t sums[] = {stats.totalLookups, stats.successfulLookups, stats.averageHops, stats.failedLookups,
+                           stats.timedOutLookups, stats.joinedNodes, stats.failedJoins, stats.churnDepartures,
+                           stats.churnRejoins};
+        MPI_Allreduce(MPI_IN_PLACE, sums, 9, MPI_UINT32_T, MPI_SUM, comm);
+        stats.totalLookups = sums[0];
+        stats.successfulLookups = sums[1];
+        stats.averageHops = sums[2];
+        stats.failedLookups = sums[3];
+        stats.timedOutLookups = sums[4];
+        stats.joinedNodes = sums[5];
+        stats.failedJoins = sums[6];
+        stats.churnDepartures = sums[7];
+        stats.churnRejoins = sums[8];
+        MPI_Allreduce(MPI_IN_PLACE, &stats.minHops, 1, MPI_UINT32_T, MPI_MIN, comm);
+        MPI_Allreduce(MPI_IN_PLACE, &stats.maxHops, 1, MPI_UINT32_T, MPI_MAX, comm);
+        uint64_t hopBuckets = stats.hopHistogram.size();
+        MPI_Allreduce(MPI_IN_PLACE, &hopBuckets, 1, MPI_UINT64_T, MPI_MAX, comm);
+        stats.hopHistogram.resize(hopBuckets, 0);
+        MPI_Allreduce(MPI_IN_PLACE, stats.hopHistogram.data(), hopBuckets, MPI_UINT64_T, MPI_SUM, comm);
+        stats.latency.AllReduce(comm);
+        stats.failureLatency.AllReduce(comm);
+        stats.timeoutLatency.AllReduce(comm);
+        stats.joinLatency.AllReduce(comm);
+        // Il tempo reale della simulazione distribuita è quello del rank più lento
+        MPI_Allreduce(MPI_IN_PLACE, &wallClock, 1, MPI_DOUBLE, MPI_MAX, comm);
+#endif
+    }
+
+    void SetWallClock(double seconds) {
+        wallClock = seconds;
+    }
+
+    // Collegamenti punto-punto tra nodi assegnati a rank diversi e ritardo minimo tra essi, che
+    // determina il lookahead della sincronizzazione (i segmenti CSMA non sono mai divisi)
+    uint32_t GetCutLinks(double& lookahead) const {
+        uint32_t cut = 0;
+        lookahead = 0.0;
+        for (const UnderlayTopology::Link& link : underlay.links) {
+            if (PartitionOf(link.a) != PartitionOf(link.b)) {
+                lookahead = cut == 0 ? link.delay : std::min(lookahead, link.delay);
+                cut++;
+            }
+        }
+        return cut;
+    }
+
+    void PrintStatistics() {
+        cout << "===========================================" << endl;
+        cout << "SIMULAZIONE CHORD - STATISTICHE FINALI" << endl;
+        cout << "===========================================" << endl;
+        cout << "Parametri di simulazione:" << endl;
+        cout << "  Numero di nodi: " << numNodes << endl;
+        cout << "  Numero di file inseriti: " << numFiles << endl;
+        cout << "  Numero di lookup eseguiti: " << numLookups << endl;
+        cout << "  Nodi che hanno fallito: " << failingNodes << " (" << (float)failingNodes/numNodes*100 << "%)" << endl;
+        cout << "  Motore: " << config.engine;
+        if (analytic) {
+            cout << " (ritardi " << (config.analyticDelay == "hops" ? std::to_string(config.hopLatency) + "s per hop"
+                                                                    : std::to_string(numRouters) + " router di underlay") << ")";
+        }
+        cout << endl;
+        if (!analytic) {
+            cout << "  Underlay: " << config.topology << " (" << underlay.links.size() << " collegamenti punto-punto, "
+                 << underlay.lans.size() << " segmenti CSMA)" << endl;
+        }
+        if (ranks > 1) {
+            double lookahead;
+            uint32_t cut = GetCutLinks(lookahead);
+            cout << "  Simulazione distribuita: " << ranks << " rank, partizione " << config.partition << ", "
+                 << cut << " collegamenti tra rank (lookahead " << lookahead * 1000 << "ms)" << endl;
+        }
+        cout << "  Tempo reale di simulazione: " << wallClock << "s" << endl;
+        cout << "  Processo di arrivo: " << config.arrival;
+        if (config.arrival != "fixed") {
+            cout << " (" << config.rate << " lookup/s, warm-up " << config.warmup << "s)";
+        }
+        cout << endl;
+        cout << "===========================================" << endl;
+        cout << "Risultati dei lookup:" << endl;
+        cout << "  Totale lookup eseguiti: " << stats.totalLookups << endl;
+        cout << "  Lookup riusciti: " << stats.successfulLookups << " (" << 
+            (stats.totalLookups > 0 ? (float)stats.successfulLookups/stats.totalLookups*100 : 0) << "%)" << endl;
+        cout << "  Lookup falliti: " << stats.failedLookups << " (" << 
+            (stats.totalLookups > 0 ? (float)stats.failedLookups/stats.totalLookups*100 : 0) << "%)" << endl;
+        
+        if (stats.successfulLookups > 0) {
+            cout << "  Media hop per lookup riuscito: " << (float)stats.averageHops / stats.successfulLookups << endl;
+            cout << "  Minimo hop per lookup riuscito: " << stats.minHops << endl;
+            cout << "  Massimo hop per lookup riuscito: " << stats.maxHops << endl;
+            cout << "  Media teorica (log2(N)): " << log2(numNodes) << endl;
+            cout << "  Latenza lookup riusciti (ms): media " << stats.latency.MeanMs()
+                 << ", p50 " << stats.latency.PercentileMs(0.5)
+                 << ", p90 " << stats.latency.PercentileMs(0.9)
+                 << ", p99 " << stats.latency.PercentileMs(0.99)
+                 << ", p99.9 " << stats.latency.PercentileMs(0.999)
+                 << ", max " << stats.latency.MaxMs() << endl;
+        } else {
+            cout << "  Media/Min/Max hop: N/A (nessun lookup riuscito)" << endl;
+        }
+        cout << "  Lookup scaduti per timeout: " << stats.timedOutLookups << endl;
+        cout << "  Finestra di misura: " << GetMeasureWindow() << "s" << endl;
+        cout << "  Carico offerto: " << GetOfferedLoad() << " lookup/s" << endl;
+        cout << "  Throughput (lookup riusciti): " << GetThroughput() << " lookup/s" << endl;
+        cout << "  Modalità di lookup: " << config.lookupMode;
+        if (config.lookupMode != "recursive") {
+            cout << " (alpha " << config.alpha << ")";
+        }
+        cout << endl;
+        cout << "  Messaggi dei lookup: " << GetLookupMessages() << " (" << GetLookupBytes() << " byte)" << endl;
+        double loadMax, loadGini, servedMax, servedGini;
+        ComputeLoadSkew(GetRequestLoad(false), loadMax, loadGini);
+        ComputeLoadSkew(GetRequestLoad(true), servedMax, servedGini);
+        cout << "  Popolarità delle chiavi: " << config.popularity << endl;
+        cout << "  Carico per nodo (richieste ricevute): max/media " << loadMax << ", Gini " << loadGini << endl;
+        cout << "  Carico per nodo (richieste servite): max/media " << servedMax << ", Gini " << servedGini << endl;
+        if (config.cacheSize > 0) {
+            cout << "  Cache delle posizioni: " << config.cacheSize << " voci per nodo, TTL " << config.cacheTtl
+                 << "s, " << GetCacheHits() << " lookup instradati dalla cache" << endl;
+        }
+        if (config.pnsCandidates > 1 || config.prs) {
+            cout << "  Selezione per prossimità: PNS " << config.pnsCandidates << " candidati, PRS "
+                 << (config.prs ? "attiva" : "disattivata") << endl;
+        }
+        cout << "Replica delle chiavi (" << config.replicas << " copie):" << endl;
+        cout << "  Copie memorizzate: " << GetStoredKeys() << " (" << (numFiles > 0 ? (double)GetStoredKeys() / numFiles : 0)
+             << " per file)" << endl;
+        cout << "  Messaggi di replica: " << GetReplicaMessages() << " (" << GetReplicaBytes() << " byte)" << endl;
+        cout << "Manutenzione dell'anello:" << endl;
+        cout << "  Periodi stabilize/fix_fingers/check_predecessor: " << config.stabilizePeriod << "s / "
+             << config.fixFingersPeriod << "s / " << config.checkPredecessorPeriod << "s" << endl;
+        cout << "  Messaggi di controllo: " << GetControlMessages() << " (" << GetControlBytes() << " byte)" << endl;
+        cout << "  Banda di controllo per nodo: " << GetControlBandwidth() << " byte/s" << endl;
+        if (config.churn != "none") {
+            cout << "Churn (" << config.churn << "):" << endl;
+            cout << "  Uscite: " << stats.churnDepartures << ", rientri: " << stats.churnRejoins
+                 << ", nodi attivi a fine simulazione: " << ring.Size() << endl;
+        }
+        if (config.joiningNodes > 0) {
+            cout << "Ingresso di nuovi nodi:" << endl;
+            cout << "  Nodi entrati: " << stats.joinedNodes << " su " << config.joiningNodes
+                 << " (falliti: " << stats.failedJoins << ")" << endl;
+            cout << "  Latenza di ingresso (ms): media " << stats.joinLatency.MeanMs()
+                 << ", p50 " << stats.joinLatency.PercentileMs(0.5)
+                 << ", p99 " << stats.joinLatency.PercentileMs(0.99)
+                 << ", max " << stats.joinLatency.MaxMs() << endl;
+            cout << "  Chiavi trasferite: " << GetKeysTransferred() << " (" << GetKeyTransferBytes() << " byte)" << endl;
+        }
+        cout << "===========================================" << endl;
+    }
+    
+    void WriteStatisticsToCSV(const std::string& filename) {
+        std::ofstream csvFile;
+        csvFile.open(filename);
+        
+        if (!csvFile.is_open()) {
+            cout << "ERRORE: Impossibile aprire il file " << filename << " per la scrittura" << endl;
+            return;
+        }
+        
+        csvFile << "NumNodes,NumFiles,NumLookups,FailingNodes,TotalLookups,SuccessfulLookups,FailedLookups,SuccessRate,AverageHops,MinHops,MaxHops,TheoreticalAverage,OfferedLoad,Throughput,"
+                << "LatencyMeanMs,LatencyP50Ms,LatencyP90Ms,LatencyP99Ms,LatencyP999Ms,LatencyMaxMs,TimedOutLookups,"
+                << "ControlMessages,ControlBytes,ControlBytesPerNodePerSec,"
+                << "JoinedNodes,JoinLatencyMeanMs,JoinLatencyP99Ms,KeysTransferred,KeyTransferBytes,"
+                << "ChurnDepartures,ChurnRejoins,Replicas,StoredKeys,ReplicaMessages,ReplicaBytes,"
+                << "LookupMode,Alpha,LookupMessages,LookupBytes,PnsCandidates,Prs,CacheSize,CacheHits,"
+                << "Popularity,LoadMaxMean,LoadGini,ServedMaxMean,ServedGini,Engine,Ranks,WallClockS,Topology" << endl;
+        
+        float successRate = stats.totalLookups > 0 ? (float)stats.successfulLookups/stats.totalLookups*100 : 0;
+        float averageHops = stats.successfulLookups > 0 ? (float)stats.averageHops / stats.successfulLookups : 0;
+        float theoreticalAverage = log2(numNodes);
+        double loadMax, loadGini, servedMax, servedGini;
+        ComputeLoadSkew(GetRequestLoad(false), loadMax, loadGini);
+        ComputeLoadSkew(GetRequestLoad(true), servedMax, servedGini);
+        
+        csvFile << numNodes << ","
+                << numFiles << ","
+                << numLookups << ","
+                << failingNodes << ","
+                << stats.totalLookups << ","
+                << stats.successfulLookups << ","
+                << stats.failedLookups << ","
+                << successRate << ","
+                << averageHops << ","
+                << (stats.successfulLookups > 0 ? stats.minHops : 0) << ","
+                << (stats.successfulLookups > 0 ? stats.maxHops : 0) << ","
+                << theoreticalAverage << ","
+                << GetOfferedLoad() << ","
+                << GetThroughput() << ","
+                << stats.latency.MeanMs() << ","
+                << stats.latency.PercentileMs(0.5) << ","
+                << stats.latency.PercentileMs(0.9) << ","
+                << stats.latency.PercentileMs(0.99) << ","
+                << stats.latency.PercentileMs(0.999) << ","
+                << stats.latency.MaxMs() << ","
+                << stats.timedOutLookups << ","
+                << GetControlMessages() << ","
+                << GetControlBytes() << ","
+                << GetControlBandwidth() << ","
+                << stats.joinedNodes << ","
+                << stats.joinLatency.MeanMs() << ","
+                << stats.joinLatency.PercentileMs(0.99) << ","
+                << GetKeysTransferred() << ","
+                << GetKeyTransferBytes() << ","
+                << stats.churnDepartures << ","
+                << stats.churnRejoins << ","
+                << config.replicas << ","
+                << GetStoredKeys() << ","
+                << GetReplicaMessages() << ","
+                << GetReplicaBytes() << ","
+                << config.lookupMode << ","
+                << config.alpha << ","
+                << GetLookupMessages() << ","
+                << GetLookupBytes() << ","
+                << config.pnsCandidates << ","
+                << (config.prs ? 1 : 0) << ","
+                << config.cacheSize << ","
+                << GetCacheHits() << ","
+                << config.popularity << ","
+                << loadMax << ","
+                << loadGini << ","
+                << servedMax << ","
+                << servedGini << ","
+                << config.engine << ","
+                << ranks << ","
+                << wallClock << ","
+                << config.topology << endl;
+        
+        csvFile.close();
+        cout << "Statistiche scritte nel file " << filename << endl;
+    }
+
+    // Esporta gli istogrammi completi (latenze, hop, fallimenti) in formato JSON
+    void WriteStatisticsToJSON(const std::string& filename) {
+        std::ofstream jsonFile(filename);
+        if (!jsonFile.is_open()) {
+            cout << "ERRORE: Impossibile aprire il file " << filename << " per la scrittura" << endl;
+            return;
+        }
+
+        jsonFile << "{" << endl;
+        jsonFile << "  \"nodes\": " << numNodes << "," << endl;
+        jsonFile << "  \"files\": " << numFiles << "," << endl;
+        jsonFile << "  \"failing\": " << failingNodes << "," << endl;
+        jsonFile << "  \"engine\": \"" << config.engine << "\"," << endl;
+        jsonFile << "  \"ranks\": " << ranks << "," << endl;
+        jsonFile << "  \"topology\": \"" << config.topology << "\"," << endl;
+        jsonFile << "  \"wall_clock_s\": " << wallClock << "," << endl;
+        jsonFile << "  \"arrival\": \"" << config.arrival << "\"," << endl;
+        jsonFile << "  \"lookup_mode\": \"" << config.lookupMode << "\"," << endl;
+        jsonFile << "  \"alpha\": " << config.alpha << "," << endl;
+        jsonFile << "  \"lookup_messages\": " << GetLookupMessages() << "," << endl;
+        jsonFile << "  \"lookup_bytes\": " << GetLookupBytes() << "," << endl;
+        jsonFile << "  \"pns_candidates\": " << config.pnsCandidates << "," << endl;
+        jsonFile << "  \"prs\": " << (config.prs ? "true" : "false") << "," << endl;
+        jsonFile << "  \"cache_size\": " << config.cacheSize << "," << endl;
+        jsonFile << "  \"cache_hits\": " << GetCacheHits() << "," << endl;
+        jsonFile << "  \"total_lookups\": " << stats.totalLookups << "," << endl;
+        jsonFile << "  \"successful_lookups\": " << stats.successfulLookups << "," << endl;
+        jsonFile << "  \"failed_lookups\": " << stats.failedLookups << "," << endl;
+        jsonFile << "  \"timed_out_lookups\": " << stats.timedOutLookups << "," << endl;
+        jsonFile << "  \"offered_load\": " << GetOfferedLoad() << "," << endl;
+        jsonFile << "  \"throughput\": " << GetThroughput() << "," << endl;
+        jsonFile << "  \"control_messages\": " << GetControlMessages() << "," << endl;
+        jsonFile << "  \"control_bytes\": " << GetControlBytes() << "," << endl;
+        jsonFile << "  \"control_bytes_per_node_per_sec\": " << GetControlBandwidth() << "," << endl;
+        jsonFile << "  \"joined_nodes\": " << stats.joinedNodes << "," << endl;
+        jsonFile << "  \"failed_joins\": " << stats.failedJoins << "," << endl;
+        jsonFile << "  \"keys_transferred\": " << GetKeysTransferred() << "," << endl;
+        jsonFile << "  \"key_transfer_bytes\": " << GetKeyTransferBytes() << "," << endl;
+        jsonFile << "  \"replicas\": " << config.replicas << "," << endl;
+        jsonFile << "  \"stored_keys\": " << GetStoredKeys() << "," << endl;
+        jsonFile << "  \"replica_messages\": " << GetReplicaMessages() << "," << endl;
+        jsonFile << "  \"replica_bytes\": " << GetReplicaBytes() << "," << endl;
+        jsonFile << "  \"churn\": \"" << config.churn << "\"," << endl;
+        jsonFile << "  \"churn_departures\": " << stats.churnDepartures << "," << endl;
+        jsonFile << "  \"churn_rejoins\": " << stats.churnRejoins << "," << endl;
+        jsonFile << "  \"join_latency_us\": ";
+        stats.joinLatency.WriteJson(jsonFile);
+        jsonFile << "," << endl;
+        jsonFile << "  \"latency_percentiles_ms\": {\"p50\": " << stats.latency.PercentileMs(0.5)
+                 << ", \"p90\": " << stats.latency.PercentileMs(0.9)
+                 << ", \"p99\": " << stats.latency.PercentileMs(0.99)
+                 << ", \"p999\": " << stats.latency.PercentileMs(0.999) << "}," << endl;
+        jsonFile << "  \"latency_us\": ";
+        stats.latency.WriteJson(jsonFile);
+        jsonFile << "," << endl;
+        jsonFile << "  \"failure_latency_us\": ";
+        stats.failureLatency.WriteJson(jsonFile);
+        jsonFile << "," << endl;
+        jsonFile << "  \"timeout_latency_us\": ";
+        stats.timeoutLatency.WriteJson(jsonFile);
+        jsonFile << "," << endl;
+        std::vector<uint64_t> requestLoad = GetRequestLoad(false);
+        double loadMax, loadGini;
+        ComputeLoadSkew(requestLoad, loadMax, loadGini);
+        jsonFile << "  \"popularity\": \"" << config.popularity << "\"," << endl;
+        jsonFile << "  \"load_max_over_mean\": " << loadMax << "," << endl;
+        jsonFile << "  \"load_gini\": " << loadGini << "," << endl;
+        jsonFile << "  \"request_load\": [";
+        for (size_t i = 0; i < requestLoad.size(); i++) {
+            jsonFile << (i > 0 ? ", " : "") << requestLoad[i];
+        }
+        jsonFile << "]," << endl;
+        jsonFile << "  \"hops\": [";
+        for (size_t i = 0; i < stats.hopHistogram.size(); i++) {
+            jsonFile << (i > 0 ? ", " : "") << stats.hopHistogram[i];
+        }
+        jsonFile << "]" << endl;
+        jsonFile << "}" << endl;
+
+        cout << "Istogrammi scritti nel file " << filename << endl;
+    }
+
+    // Durata della finestra di misura e tassi di lookup offerti e completati con successo
+    double GetMeasureWindow() const {
+        return measureEnd > measureStart && measureEnd != Time::Max() ? (measureEnd - measureStart).GetSeconds() : 0.0;
+    }
+
+    double GetOfferedLoad() const {
+        double window = GetMeasureWindow();
+        return window > 0 ? stats.totalLookups / window : 0.0;
+    }
+
+    double GetThroughput() const {
+        double window = GetMeasureWindow();
+        return window > 0 ? stats.successfulLookups / window : 0.0;
+    }
+
+    // Istantanea finale dei contatori per nodo
+    void WriteNodeStats() {
+        if (!nodeStatsOut.is_open()) {
+            return;
+        }
+        WriteNodeStatsSnapshot();
+        nodeStatsOut.close();
+        cout << "Contatori per nodo scritti nel file " << config.nodeStatsFile << endl;
+    }
+
+    // Traffico dei protocolli di manutenzione su tutta la simulazione
+    uint64_t GetControlMessages() const {
+        uint64_t total = 0;
+        for (const auto& app : applications) {
+            total += app->GetControlMessages();
+        }
+        return SumOverRanks(total);
+    }
+
+    uint64_t GetControlBytes() const {
+        uint64_t total = 0;
+        for (const auto& app : applications) {
+            total += app->GetControlBytes();
+        }
+        return SumOverRanks(total);
+    }
+
+    // Traffico dei lookup (richieste, risposte, conferme, FIND_NEXT_HOP e notifiche di avanzamento)
+    uint64_t GetLookupMessages() const {
+        uint64_t total = 0;
+        for (const auto& app : applications) {
+            total += app->GetLookupMessages();
+        }
+        return SumOverRanks(total);
+    }
+
+    uint64_t GetLookupBytes() const {
+        uint64_t total = 0;
+        for (const auto& app : applications) {
+            total += app->GetLookupBytes();
+        }
+        return SumOverRanks(total);
+    }
+
+    uint64_t GetCacheHits() const {
+        uint64_t total = 0;
+        for (const auto& app : applications) {
+            total += app->GetCacheHits();
+        }
+        return SumOverRanks(total);
+    }
+
+    // Byte di controllo al secondo per nodo, mediati sulla durata simulata
+    double GetControlBandwidth() const {
+        double elapsed = Simulator::Now().GetSeconds();
+        return elapsed > 0 && totalNodes > 0 ? GetControlBytes() / (double)totalNodes / elapsed : 0.0;
+    }
+
+    // Chiavi cedute ai nodi entrati e relativi byte a livello IP
+    uint64_t GetKeysTransferred() const {
+        uint64_t total = 0;
+        for (const auto& app : applications) {
+            total += app->GetKeysTransferred();
+        }
+        return SumOverRanks(total);
+    }
+
+    uint64_t GetKeyTransferBytes() const {
+        uint64_t total = 0;
+        for (const auto& app : applications) {
+            total += app->GetKeyTransferBytes();
+        }
+        return SumOverRanks(total);
+    }
+
+    // Copie memorizzate su tutti i nodi (vivi o meno) e traffico per crearle
+    uint64_t GetStoredKeys() const {
+        uint64_t total = 0;
+        for (const auto& app : applications) {
+            total += app->GetStoredKeys();
+        }
+        return SumOverRanks(total);
+    }
+
+    uint64_t GetReplicaMessages() const {
+        uint64_t total = 0;
+        for (const auto& app : applications) {
+            total += app->GetReplicaMessages();
+        }
+        return SumOverRanks(total);
+    }
+
+    uint64_t GetReplicaBytes() const {
+        uint64_t total = 0;
+        for (const auto& app : applications) {
+            total += app->GetReplicaBytes();
+        }
+        return SumOverRanks(total);
+    }
+
+    void UpdateStats(bool success, uint32_t hops, uint32_t lookupId, Time latency, bool timedOut) {
+        // La serie temporale include anche il warm-up, per mostrare il transitorio
+        timeSeries.completed++;
+        if (success) {
+            timeSeries.successful++;
+            timeSeries.latency.Record(latency);
+        } else if (timedOut) {
+            timeSeries.timedOut++;
+        }
+
+        // I lookup avviati durante il warm-up non entrano nelle statistiche
+        if (lookupId < firstMeasuredLookupId) {
+            return;
+        }
+
+        if (processedLookups.find(lookupId) != processedLookups.end()) {
+            NS_LOG_WARN("Lookup " << lookupId << " already processed, ignoring duplicate");
+            return;
+        }
+        
+        processedLookups.insert(lookupId);
+        
+        if (success) {
+            stats.successfulLookups++;
+            stats.averageHops += hops;
+            
+            if (hops < stats.minHops) {
+                stats.minHops = hops;
+            }
+            if (hops > stats.maxHops) {
+                stats.maxHops = hops;
+            }
+            if (hops >= stats.hopHistogram.size()) {
+                stats.hopHistogram.resize(hops + 1, 0);
+            }
+            stats.hopHistogram[hops]++;
+            stats.latency.Record(latency);
+            
+            NS_LOG_DEBUG("Lookup " << lookupId << " riuscito dopo " << hops << " hop in " << latency.GetMilliSeconds() << "ms");
+        } else {
+            stats.failedLookups++;
+            stats.failureLatency.Record(latency);
+            if (timedOut) {
+                stats.timedOutLookups++;
+                stats.timeoutLatency.Record(latency);
+            }
+            NS_LOG_DEBUG("Lookup " << lookupId << " fallito" << (timedOut ? " per timeout" : ""));
+        }
+        
+        NS_LOG_LOGIC("Statistiche aggiornate: total " << stats.totalLookups
+                     << ", successful " << stats.successfulLookups
+                     << ", failed " << stats.failedLookups
+                     << ", hop sum " << stats.averageHops);
+    }
+
+    void PrepareFilesToLookup() {
+        filesForLookup.clear();
+        
+        cout << "Preparazione di " << numLookups << " file da cercare tra i " << files.size() << " inseriti" << endl;
+
+        PreparePopularity();
+        if (config.popularity != "uniform") {
+            // Il workload a tasso estrae le chiavi al momento dell'arrivo: un'estrazione anticipata
+            // consumerebbe la traccia e il generatore della popolarità
+            if (config.arrival != "fixed") {
+                cout << "Le chiavi verranno estratte all'arrivo di ogni lookup (popolarità " << config.popularity
+                     << ")" << endl;
+                return;
+            }
+            for (uint32_t i = 0; i < numLookups && !files.empty(); i++) {
+                filesForLookup.push_back(NextLookupKey());
+            }
+            std::set<ChordId> distinct(filesForLookup.begin(), filesForLookup.end());
+            cout << "Estratti " << filesForLookup.size() << " lookup su " << distinct.size()
+                 << " file distinti (popolarità " << config.popularity << ")" << endl;
+            return;
+        }
+        
+        if (numLookups >= numFiles) {
+            filesForLookup = files;
+            cout << "Cercheremo tutti i " << filesForLookup.size() << " file inseriti" << endl;
+            return;
+        }
+        
+        Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable>();
+        std::set<uint32_t> selectedIndices;  
+        
+        while (selectedIndices.size() < numLookups) {
+            uint32_t index = rng->GetInteger(0, numFiles - 1);
+            if (selectedIndices.find(index) == selectedIndices.end()) {
+                selectedIndices.insert(index);
+                filesForLookup.push_back(files[index]);
+            }
+        }
+        
+        cout << "Selezionati " << filesForLookup.size() << " file da cercare" << endl;
+    }
+
+    // Carico delle richieste per nodo: rapporto tra massimo e media e coefficiente di Gini, sui nodi
+    // attivi a fine simulazione e su quelli che hanno ricevuto almeno una richiesta
+    std::vector<uint64_t> GetRequestLoad(bool served) const {
+        std::vector<uint64_t> values(nodes.size(), 0);
+        for (uint32_t i = 0; i < nodes.size(); i++) {
+            if (analytic) {
+                values[i] = served ? analyticServed[i] : analyticHandled[i];
+            } else if (i < applications.size()) {
+                values[i] = served ? applications[i]->GetRequestsServed() : applications[i]->GetRequestsHandled();
+            }
+        }
+        SumOverRanks(values);
+        std::vector<uint64_t> load;
+        for (uint32_t i = 0; i < nodes.size(); i++) {
+            if (nodes[i].isAlive || values[i] > 0) {
+                load.push_back(values[i]);
+            }
+        }
+        return load;
+    }
+
+    static void ComputeLoadSkew(std::vector<uint64_t> load, double& maxOverMean, double& gini) {
+        maxOverMean = 0.0;
+        gini = 0.0;
+        double total = 0.0;
+        for (uint64_t value : load) {
+            total += value;
+        }
+        if (load.empty() || total <= 0) {
+            return;
+        }
+        std::sort(load.begin(), load.end());
+        double weighted = 0.0;
+        for (size_t i = 0; i < load.size(); i++) {
+            weighted += (i + 1) * (double)load[i];
+        }
+        double n = load.size();
+        maxOverMean = load.back() / (total / n);
+        gini = 2 * weighted / (n * total) - (n + 1) / n;
+    }
+
+private:
+    // Prepara le tabelle del modello di popolarità
+    void PreparePopularity() {
+        popularityRng = CreateObject<UniformRandomVariable>();
+        if (config.popularity == "zipf") {
+            zipfCdf.resize(files.size());
+            double sum = 0.0;
+            for (size_t k = 0; k < files.size(); k++) {
+                sum += 1.0 / std::pow(k + 1, config.zipfAlpha);
+                zipfCdf[k] = sum;
+            }
+            for (double& value : zipfCdf) {
+                value /= sum;
+            }
+        } else if (config.popularity == "hotset") {
+            hotKeys = std::max<uint32_t>(1, std::ceil(config.hotFraction * files.size()));
+        } else if (config.popularity == "trace") {
+            ResolveKeyTrace();
+        }
+    }
+
+    // Le righe della traccia sono nomi di chiave, con lo stesso ID che ricevono con --keys (SHA-1 del
+    // nome); senza --keys una riga di sole cifre k indica ancora il file k modulo il numero di file
+    void ResolveKeyTrace() {
+        keyTrace.clear();
+        uint32_t named = 0;
+        for (const std::string& key : config.traceKeys) {
+            bool index = config.keyNames.empty() && !files.empty()
+                         && key.find_first_not_of("0123456789") == std::string::npos;
+            if (index) {
+                keyTrace.push_back(files[std::strtoull(key.c_str(), nullptr, 10) % files.size()]);
+            } else {
+                keyTrace.push_back(HashKey(key, m));
+                named++;
+            }
+        }
+        cout << "Letta la traccia " << config.traceFile << " con " << keyTrace.size() << " chiavi (" << named
+             << " per nome)" << endl;
+    }
+
+    // Chiave del prossimo lookup secondo il modello di popolarità
+    ChordId NextLookupKey() {
+        if (config.popularity == "zipf") {
+            double u = popularityRng->GetValue(0.0, 1.0);
+            size_t rank = std::lower_bound(zipfCdf.begin(), zipfCdf.end(), u) - zipfCdf.begin();
+            return files[std::min(rank, files.size() - 1)];
+        }
+        if (config.popularity == "hotset") {
+            if (hotKeys >= files.size() || popularityRng->GetValue(0.0, 1.0) < config.hotProbability) {
+                return files[popularityRng->GetInteger(0, hotKeys - 1)];
+            }
+            return files[popularityRng->GetInteger(hotKeys, files.size() - 1)];
+        }
+        if (config.popularity == "trace") {
+            return keyTrace[tracePosition++ % keyTrace.size()];
+        }
+        return files[popularityRng->GetInteger(0, files.size() - 1)];
+    }
+
+    // Tabelle di routing, file e chiavi memorizzate presi dall'istantanea; le chiavi sono già
+    // sui nodi all'avvio, quindi la fase di inserimento non invia messaggi
+    void RestoreRing() {
+        uint32_t m = config.m;
+        for (uint32_t i = 0; i < totalNodes; i++) {
+            ChordNode& node = nodes[i];
+            node.predecessor = snapshot.predecessors[i];
+            node.fingerTable.assign(snapshot.fingers + (size_t)i * m, snapshot.fingers + (size_t)(i + 1) * m);
+            node.successorList.assign(snapshot.successors + snapshot.successorOffsets[i],
+                                      snapshot.successors + snapshot.successorOffsets[i + 1]);
+            for (uint32_t k = snapshot.rttOffsets[i]; k < snapshot.rttOffsets[i + 1]; k++) {
+                node.neighborRtt[snapshot.rttIds[k]] = snapshot.rttValues[k];
+            }
+            node.storedFiles.insert(snapshot.storedKeys + snapshot.storedOffsets[i],
+                                    snapshot.storedKeys + snapshot.storedOffsets[i + 1]);
+        }
+        files.assign(snapshot.files, snapshot.files + snapshot.header->numFiles);
+        createChordApplications();
+        for (uint32_t i = 0; i < totalNodes; i++) {
+            applications[i]->PreloadFiles(nodes[i].storedFiles);
+        }
+        cout << "Anello ripristinato dall'istantanea " << config.loadRing << endl;
+    }
+
+public:
+    // Scrive l'anello appena costruito. Le chiavi memorizzate sono quelle che la fase di inserimento
+    // produce senza guasti: il responsabile di ogni file e i primi replicas-1 successori
+    void SaveRing(const std::string& filename) {
+        if (rank != 0) {
+            return;
+        }
+        std::vector<std::vector<ChordId>> stored(totalNodes);
+        for (ChordId fileId : files) {
+            uint32_t responsible = chordIdToIndex[findSuccessor(fileId)];
+            stored[responsible].push_back(fileId);
+            uint32_t replica = 1;
+            for (ChordId id : nodes[responsible].successorList) {
+                if (replica >= config.replicas) {
+                    break;
+                }
+                if (id != nodes[responsible].chordId) {
+                    stored[chordIdToIndex[id]].push_back(fileId);
+                    replica++;
+                }
+            }
+        }
+        if (RingSnapshot::Write(filename, config, nodes, files, stored, underlay)) {
+            cout << "Istantanea dell'anello salvata nel file " << filename << endl;
+        } else {
+            cout << "ERRORE: Impossibile scrivere l'istantanea dell'anello " << filename << endl;
+        }
+    }
+
+private:
+    // ChordID distinti per tutti i nodi; solo i nodi iniziali fanno parte dell'anello,
+    // gli altri vi entrano con il protocollo di JOIN
+    std::vector<ChordId> GenerateChordIds() {
+        Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable>();
+        std::set<ChordId> usedIds; 
+        std::vector<ChordId> chordIds(totalNodes);
+
+        NS_LOG_DEBUG("Generazione di " << totalNodes << " ChordID nello spazio di " << m << " bit");
+
+        for (uint32_t i = 0; i < totalNodes; i++) {
+            ChordId chordId;
+            do {
+                chordId = RandomId(rng, m);
+            } while (usedIds.find(chordId) != usedIds.end());
+            
+            usedIds.insert(chordId);
+            chordIds[i] = chordId;
+            NS_LOG_LOGIC("Nodo " << i << " ha ChordID " << chordId);
+        }
+        ring.Build(std::vector<ChordId>(chordIds.begin(), chordIds.begin() + numNodes));
+        return chordIds;
+    }
+
+    // Motore analitico: solo lo stato di overlay dei nodi e il modello dei ritardi dell'underlay
+    void createOverlayNodes() {
+        std::vector<ChordId> chordIds = GenerateChordIds();
+        nodes.reserve(totalNodes);
+        for (uint32_t i = 0; i < totalNodes; i++) {
+            nodes.push_back(ChordNode(chordIds[i], Ptr<Node>()));
+            chordIdToIndex[chordIds[i]] = i;
+            nodes[i].isAlive = i < numNodes;
+        }
+        analyticSuspected.assign(totalNodes, std::vector<ChordId>());
+        analyticFingers.assign(totalNodes, FlatFingerTable());
+        analyticHandled.assign(totalNodes, 0);
+        analyticServed.assign(totalNodes, 0);
+        if (config.analyticDelay == "underlay") {
+            BuildAnalyticUnderlay();
+        }
+    }
+
+    // Stesso generatore della rete a pacchetti su al più ANALYTIC_ROUTERS router (con "file" i router
+    // sono i nodi del file) e ritardi tra tutte le coppie di router calcolati con Dijkstra da ciascuno
+    void BuildAnalyticUnderlay() {
+        Ptr<UniformRandomVariable> r = CreateObject<UniformRandomVariable>();
+        UnderlayTopology routers;
+        std::string error;
+        if (!TopologyGenerator::Generate(config, std::min(totalNodes, ANALYTIC_ROUTERS), r, routers, error)) {
+            cout << "ERRORE: " << error << endl;
+            return;
+        }
+        numRouters = routers.numNodes;
+
+        routerDelay.assign((size_t)numRouters * numRouters, 0.0f);
+        std::vector<double> delay;
+        for (uint32_t source = 0; source < numRouters; source++) {
+            routers.ShortestDelays(source, delay);
+            std::copy(delay.begin(), delay.end(), routerDelay.begin() + (size_t)source * numRouters);
+        }
+
+        accessRouter.resize(totalNodes);
+        for (uint32_t i = 0; i < totalNodes; i++) {
+            accessRouter[i] = i < numRouters ? i : r->GetInteger(0, numRouters - 1);
+        }
+        NS_LOG_DEBUG("Underlay analitico: " << numRouters << " router per " << totalNodes << " nodi");
+    }
+
+    // Ritardo di un messaggio tra due nodi: propagazione lungo i collegamenti del percorso più breve,
+    // senza code né tempi di trasmissione, oppure un ritardo fisso per hop di overlay
+    Time AnalyticDelay(uint32_t from, uint32_t to) const {
+        if (from == to) {
+            return Seconds(0);
+        }
+        if (config.analyticDelay == "hops") {
+            return Seconds(config.hopLatency);
+        }
+        uint32_t accessLinks = (from >= numRouters ? 1 : 0) + (to >= numRouters ? 1 : 0);
+        return Seconds(routerDelay[(size_t)accessRouter[from] * numRouters + accessRouter[to]]
+                       + accessLinks * config.linkDelay);
+    }
+
+    bool IsAnalyticSuspected(uint32_t nodeIndex, ChordId chordId) const {
+        const std::vector<ChordId>& suspected = analyticSuspected[nodeIndex];
+        return std::find(suspected.begin(), suspected.end(), chordId) != suspected.end();
+    }
+
+    // Equivalente di PerformLookup: controllo locale e primo hop dall'origine
+    void StartAnalyticLookup(uint32_t origin, ChordId fileId, uint32_t lookupId) {
+        if (!nodes[origin].isAlive) {
+            UpdateStats(false, 0, lookupId, Seconds(0), false);
+            return;
+        }
+        if (nodes[origin].storedFiles.count(fileId) > 0) {
+            UpdateStats(true, 0, lookupId, Seconds(0), false);
+            return;
+        }
+        AnalyticLookup lookup;
+        lookup.lookupId = lookupId;
+        lookup.fileId = fileId;
+        lookup.origin = origin;
+        lookup.startTime = Simulator::Now();
+        lookup.hopCount = 0;
+        lookup.owner = false;
+        if (!AnalyticRoute(lookup, origin)) {
+            UpdateStats(false, 0, lookupId, Seconds(0), false);
+        }
+    }
+
+    // Sceglie il prossimo hop da nodeIndex con la stessa regola delle applicazioni
+    bool AnalyticRoute(AnalyticLookup lookup, uint32_t nodeIndex) {
+        const ChordNode& node = nodes[nodeIndex];
+        bool owner = false;
+        ChordId nextHop = SelectNextHop(node.chordId, lookup.fileId, analyticFingers[nodeIndex], node.successorList,
+                                        [this, nodeIndex](ChordId id) { return !IsAnalyticSuspected(nodeIndex, id); },
+                                        owner);
+        if (nextHop == node.chordId) {
+            return false;
+        }
+        lookup.owner = owner;
+        AnalyticSend(lookup, nodeIndex, chordIdToIndex[nextHop]);
+        return true;
+    }
+
+    // Un hop verso un nodo guasto costa il timeout di hop, dopo il quale il mittente lo sospetta
+    // e reinstrada; senza conferme hop-by-hop la richiesta è persa e il lookup scade
+    void AnalyticSend(const AnalyticLookup& lookup, uint32_t from, uint32_t to) {
+        Time deadline = lookup.startTime + timeoutDuration;
+        if (!nodes[to].isAlive) {
+            if (config.hopTimeout > 0 && Simulator::Now() + Seconds(config.hopTimeout) < deadline) {
+                Simulator::Schedule(Seconds(config.hopTimeout), &ChordNetwork::AnalyticHopTimeout, this, lookup, from, to);
+            } else {
+                Simulator::Schedule(deadline - Simulator::Now(), &ChordNetwork::AnalyticTimeout, this, lookup);
+            }
+            return;
+        }
+        Time delay = AnalyticDelay(from, to);
+        if (Simulator::Now() + delay >= deadline) {
+            Simulator::Schedule(deadline - Simulator::Now(), &ChordNetwork::AnalyticTimeout, this, lookup);
+            return;
+        }
+        Simulator::Schedule(delay, &ChordNetwork::AnalyticArrive, this, lookup, to);
+    }
+
+    void AnalyticHopTimeout(AnalyticLookup lookup, uint32_t from, uint32_t deadHop) {
+        analyticSuspected[from].push_back(nodes[deadHop].chordId);
+        if (!AnalyticRoute(lookup, from)) {
+            AnalyticRespond(lookup, from, false, lookup.hopCount);
+        }
+    }
+
+    // Equivalente di HandleLookup
+    void AnalyticArrive(AnalyticLookup lookup, uint32_t nodeIndex) {
+        analyticHandled[nodeIndex]++;
+        const ChordNode& node = nodes[nodeIndex];
+        if (lookup.hopCount > ChordApplication::MAX_LOOKUP_HOPS) {
+            AnalyticRespond(lookup, nodeIndex, false, lookup.hopCount);
+            return;
+        }
+        if (node.storedFiles.count(lookup.fileId) > 0) {
+            analyticServed[nodeIndex]++;
+            AnalyticRespond(lookup, nodeIndex, true, lookup.hopCount + 1);
+            return;
+        }
+
+        uint32_t hopCount = lookup.hopCount;
+        lookup.hopCount++;
+        if (lookup.owner) {
+            if (node.predecessor == node.chordId || IsInRingRange(lookup.fileId, node.predecessor, node.chordId)) {
+                AnalyticRespond(lookup, nodeIndex, false, hopCount + 1);
+                return;
+            }
+            if (!IsAnalyticSuspected(nodeIndex, node.predecessor)) {
+                AnalyticSend(lookup, nodeIndex, chordIdToIndex[node.predecessor]);
+                return;
+            }
+        }
+        if (!AnalyticRoute(lookup, nodeIndex)) {
+            AnalyticRespond(lookup, nodeIndex, false, hopCount);
+        }
+    }
+
+    // La risposta torna direttamente all'origine
+    void AnalyticRespond(const AnalyticLookup& lookup, uint32_t from, bool success, uint32_t hopCount) {
+        Time deadline = lookup.startTime + timeoutDuration;
+        Time arrival = Simulator::Now() + AnalyticDelay(from, lookup.origin);
+        if (arrival >= deadline) {
+            Simulator::Schedule(deadline - Simulator::Now(), &ChordNetwork::AnalyticTimeout, this, lookup);
+            return;
+        }
+        Simulator::Schedule(arrival - Simulator::Now(), &ChordNetwork::AnalyticComplete, this, lookup, success, hopCount);
+    }
+
+    void AnalyticComplete(AnalyticLookup lookup, bool success, uint32_t hopCount) {
+        UpdateStats(success, hopCount, lookup.lookupId, Simulator::Now() - lookup.startTime, false);
+    }
+
+    void AnalyticTimeout(AnalyticLookup lookup) {
+        UpdateStats(false, 0, lookup.lookupId, Simulator::Now() - lookup.startTime, true);
+    }
+
+    // Equivalente di HandleStore: il responsabile memorizza il file e lo replica sui successori
+    void AnalyticStore(uint32_t nodeIndex, ChordId fileId) {
+        ChordNode& node = nodes[nodeIndex];
+        if (!node.isAlive) {
+            return;
+        }
+        node.storedFiles.insert(fileId);
+        uint32_t replica = 1;
+        for (ChordId id : node.successorList) {
+            if (replica >= config.replicas) {
+                break;
+            }
+            if (id == node.chordId) {
+                continue;
+            }
+            replica++;
+            ChordNode& successor = nodes[chordIdToIndex[id]];
+            if (successor.isAlive) {
+                successor.storedFiles.insert(fileId);
+            }
+        }
+    }
+
+    // Avvia un lookup con il motore configurato; false se il nodo non può avviarlo
+    bool StartLookup(uint32_t nodeIndex, ChordId fileId, uint32_t lookupId) {
+        if (analytic) {
+            StartAnalyticLookup(nodeIndex, fileId, lookupId);
+            return true;
+        }
+        if (nodeIndex >= applications.size() || !applications[nodeIndex] || !applications[nodeIndex]->IsStarted()) {
+            return false;
+        }
+        applications[nodeIndex]->PerformLookup(fileId, timeoutDuration, lookupId);
+        return true;
+    }
+
+    // Rank proprietario di un nodo fisico
+    uint32_t PartitionOf(uint32_t nodeIndex) const {
+        if (ranks <= 1) {
+            return 0;
+        }
+        // Un segmento CSMA non può attraversare rank diversi: tutti i suoi nodi seguono il primo
+        if (config.topology == "lan") {
+            nodeIndex -= nodeIndex % config.domainSize;
+        }
+        if (config.partition == "roundrobin") {
+            return nodeIndex % ranks;
+        }
+        return (uint64_t)nodeIndex * ranks / totalNodes;
+    }
+
+    // Vero se le applicazioni del nodo girano in questo processo
+    bool IsLocal(uint32_t nodeIndex) const {
+        return ranks <= 1 || PartitionOf(nodeIndex) == rank;
+    }
+
+    // Somma su tutti i rank di una simulazione distribuita: ogni rank deve chiamarla negli stessi
+    // punti, quindi solo in percorsi che dipendono da valori già uguali su tutti i rank
+    uint64_t SumOverRanks(uint64_t value) const {
+#ifdef NS3_MPI
+        if (ranks > 1) {
+            MPI_Allreduce(MPI_IN_PLACE, &value, 1, MPI_UINT64_T, MPI_SUM, MpiInterface::GetCommunicator());
+        }
+#endif
+        return value;
+    }
+
+    void SumOverRanks(std::vector<uint64_t>& values) const {
+#ifdef NS3_MPI
+        if (ranks > 1) {
+            MPI_Allreduce(MPI_IN_PLACE, values.data(), values.size(), MPI_UINT64_T, MPI_SUM,
+                          MpiInterface::GetCommunicator());
+        }
+#else
+        (void)values;
+#endif
+    }
+
+    void createPhysicalNetwork() {
+        for (uint32_t i = 0; i < totalNodes; i++) {
+            nsNodes.Create(1, PartitionOf(i));
+        }
+        
+        // Setup del routing
+        Ipv4NixVectorHelper nixRouting;
+        InternetStackHelper stackIP;
+        stackIP.SetRoutingHelper(nixRouting);
+        stackIP.Install(nsNodes);
+
+        Ipv4AddressHelper ipv4;
+        ipv4.SetBase ("10.0.0.0", "/30");
+        
+        std::vector<ChordId> chordIds;
+        if (ringRestored) {
+            chordIds.assign(snapshot.ids, snapshot.ids + totalNodes);
+            ring.Build(std::vector<ChordId>(chordIds.begin(), chordIds.begin() + numNodes));
+            snapshot.GetTopology(underlay);
+        } else {
+            chordIds = GenerateChordIds();
+        }
+        for (uint32_t i = 0; i < totalNodes; i++) {
+            nodes.push_back(ChordNode(chordIds[i], nsNodes.Get(i)));
+        }
+
+        // La validità della topologia da file è controllata in main
+        std::string error;
+        if (!ringRestored) {
+            Ptr<UniformRandomVariable> r = CreateObject<UniformRandomVariable>();
+            if (!TopologyGenerator::Generate(config, totalNodes, r, underlay, error)) {
+                cout << "ERRORE: " << error << endl;
+                return;
+            }
+        }
+
+        // Ogni collegamento punto-punto ha la sua sottorete /30, ogni segmento CSMA la più piccola
+        // sottorete che ne contiene i nodi
+        PointToPointHelper p2p;
+        for (const UnderlayTopology::Link& link : underlay.links) {
+            p2p.SetDeviceAttribute ("DataRate", DataRateValue (DataRate (link.rate)));
+            p2p.SetChannelAttribute ("Delay", TimeValue (Seconds (link.delay)));
+            NetDeviceContainer dev = p2p.Install(nsNodes.Get(link.a), nsNodes.Get(link.b));
+            ipv4.Assign(dev);
+            ipv4.NewNetwork();
+        }
+        if (!underlay.lans.empty()) {
+            uint32_t hostBits = 2;
+            while ((1u << hostBits) < config.domainSize + 2) {
+                hostBits++;
+            }
+            Ipv4AddressHelper lanIpv4;
+            lanIpv4.SetBase ("100.64.0.0", Ipv4Mask (~((1u << hostBits) - 1)));
+            CsmaHelper csma;
+            for (const UnderlayTopology::Lan& lan : underlay.lans) {
+                csma.SetChannelAttribute ("DataRate", DataRateValue (DataRate (lan.rate)));
+                csma.SetChannelAttribute ("Delay", TimeValue (Seconds (lan.delay)));
+                NodeContainer members;
+                for (uint32_t i : lan.members) {
+                    members.Add(nsNodes.Get(i));
+                }
+                lanIpv4.Assign(csma.Install(members));
+                lanIpv4.NewNetwork();
+            }
+        }
+        
+        NS_LOG_LOGIC("ChordID generati: " << FormatIds(chordIds));
+
+        for (uint32_t i = 0; i < nodes.size(); i++) {
+            chordIdToIndex[nodes[i].chordId] = i;
+            nodes[i].isAlive = i < numNodes;
+        }
+    }
+
+    // RTT dal nodo source verso tutti gli altri lungo i percorsi con meno hop, gli stessi scelti
+    // dal routing nix-vector (-1 se non raggiungibile)
+    std::vector<double> ComputeUnderlayRtt(uint32_t source) const {
+        std::vector<double> delay;
+        underlay.FewestHopDelays(source, delay);
+        for (double& d : delay) {
+            if (d >= 0) {
+                d *= 2;
+            }
+        }
+        return delay;
+    }
+
+    void RecordNeighborRtts(uint32_t nodeIndex, const std::vector<double>& rtt) {
+        ChordNode& node = nodes[nodeIndex];
+        node.neighborRtt.clear();
+        auto record = [&](ChordId id) {
+            auto it = chordIdToIndex.find(id);
+            if (id != node.chordId && it != chordIdToIndex.end() && rtt[it->second] >= 0) {
+                node.neighborRtt[id] = rtt[it->second];
+            }
+        };
+        for (ChordId id : node.fingerTable) {
+            record(id);
+        }
+        for (ChordId id : node.successorList) {
+            record(id);
+        }
+        record(node.predecessor);
+    }
+
+    // PNS: tra i primi pnsCandidates nodi dell'intervallo [start, start + width) sceglie quello
+    // con RTT minore dal nodo; first è il successore esatto di start
+    ChordId SelectProximateFinger(ChordId self, ChordId start, ChordId width, ChordId first,
+                                  const std::vector<double>& rtt) {
+        auto inInterval = [&](ChordId id) {
+            return IdSub(id, start, m) < width;
+        };
+        if (first == self || !inInterval(first)) {
+            return first;
+        }
+        ChordId best = first;
+        double bestRtt = rtt[chordIdToIndex[first]];
+        for (ChordId id : ring.Successors(first, config.pnsCandidates - 1)) {
+            if (id == self || !inInterval(id)) {
+                break;
+            }
+            double candidateRtt = rtt[chordIdToIndex[id]];
+            if (candidateRtt >= 0 && (bestRtt < 0 || candidateRtt < bestRtt)) {
+                best = id;
+                bestRtt = candidateRtt;
+            }
+        }
+        return best;
+    }
+
+    void initializeFingerTable(uint32_t nodeIndex, const std::vector<double>& rtt) {
+        ChordNode& node = nodes[nodeIndex];
+        node.fingerTable.clear();
+        
+        NS_LOG_LOGIC("Inizializzazione finger table per nodo " << nodeIndex << " con ChordID " << node.chordId);
+        
+        for (uint32_t i = 0; i < m; i++) {
+            ChordId fingerStart = IdAdd(node.chordId, IdPow2(i), m);
+            ChordId successor = findSuccessor(fingerStart);
+            if (config.pnsCandidates > 1 && !rtt.empty()) {
+                successor = SelectProximateFinger(node.chordId, fingerStart, IdPow2(i), successor, rtt);
+            }
+            node.fingerTable.push_back(successor);
+            NS_LOG_LOGIC("Finger " << i << " per nodo " << node.chordId << ": start=" << fingerStart << ", successor=" << successor);
+        }
+    }
+
+    void initializeSuccessorList(uint32_t nodeIndex) {
+        ChordNode& node = nodes[nodeIndex];
+        node.successorList.clear();
+        
+        NS_LOG_LOGIC("Inizializzazione successor list per nodo " << nodeIndex << " con ChordID " << node.chordId);
+        
+        if (!ring.Contains(node.chordId)) {
+            NS_LOG_ERROR("ChordID " << node.chordId << " non trovato nell'indice dell'anello!");
+            return;
+        }
+        
+        node.successorList = ring.Successors(node.chordId, config.successorListSize);
+        node.predecessor = ring.Predecessor(node.chordId);
+        NS_LOG_LOGIC("Successori per nodo " << node.chordId << ": " << FormatIds(node.successorList));
+    }
+
+    ChordId findSuccessor(ChordId id) {
+        if (ring.Empty()) {
+            NS_LOG_ERROR("Nessun nodo nella rete!");
+            return 0;
+        }
+        
+        ChordId successor = ring.Successor(id);
+        NS_LOG_LOGIC("findSuccessor ha trovato il nodo " << successor << " per id " << id);
+        return successor;
+    }
+
+    void createChordApplications() {
+        // Un solo lookup Ipv4 per nodo: la directory è poi condivisa da tutte le applicazioni
+        std::vector<std::pair<ChordId, Address>> addresses;
+        addresses.reserve(totalNodes);
+        for (uint32_t j = 0; j < totalNodes; j++) {
+            addresses.push_back(std::make_pair(nodes[j].chordId, getNodeAddress(j)));
+        }
+        directory = Create<ChordAddressDirectory>();
+        directory->Build(std::move(addresses));
+
+        for (uint32_t i = 0; i < totalNodes; i++) {
+            // Le applicazioni dei nodi remoti non vengono installate e non partono mai: restano
+            // nel vettore solo per mantenere gli stessi indici su tutti i rank
+            Ptr<ChordApplication> app = CreateObject<ChordApplication>();
+            if (IsLocal(i)) {
+                nsNodes.Get(i)->AddApplication(app);
+            }
+            app->SetAddressDirectory(directory);
+            app->Configure(config);
+            app->Setup(nodes[i].chordId, nodes[i].fingerTable, nodes[i].successorList, nodes[i].predecessor);
+            app->SetNeighborRtts(nodes[i].neighborRtt);
+            
+            app->SetStatsCallback(MakeCallback(&ChordNetwork::UpdateStats, this));
+            app->SetJoinCallback(MakeCallback(&ChordNetwork::OnJoinCompleted, this));
+            
+            applications.push_back(app);
+        }
+    }
+
+    Address getNodeAddress(uint32_t nodeId) {
+        if (nodeId >= nodes.size() || !nodes[nodeId].nsNode) {
+            NS_LOG_ERROR("ID nodo non valido o puntatore nodo nullo: " << nodeId);
+            return Address();
+        }
+
+        Ptr<Ipv4> ipv4 = nodes[nodeId].nsNode->GetObject<Ipv4>();
+        if (!ipv4) {
+            NS_LOG_ERROR("Nessun stack IPv4 sul nodo: " << nodeId);
+            return Address();
+        }
+
+        if (ipv4->GetNInterfaces() <= 1) {
+            NS_LOG_ERROR("Nessuna interfaccia di rete sul nodo: " << nodeId);
+            return Address();
+        }
+
+        Ipv4InterfaceAddress iaddr = ipv4->GetAddress(1,0);
+        return InetSocketAddress(iaddr.GetLocal(), 9);
+    }
+
+    void InsertFiles() {
+        Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable>();
+        
+        Time startTime = Seconds(1.0);
+        
+        NS_LOG_DEBUG("Inserimento di " << files.size() << " file nella rete");
+        
+        for (uint32_t i = 0; i < files.size(); i++) {
+            ChordId fileId = files[i];
+            uint32_t startNodeIndex = rng->GetInteger(0, numNodes - 1);
+            ChordId responsibleChordId = findSuccessor(fileId);
+            
+            if (chordIdToIndex.find(responsibleChordId) == chordIdToIndex.end()) {
+                NS_LOG_ERROR("ChordID " << responsibleChordId << " non trovato nella mappa!");
+                continue;
+            }
+            uint32_t responsibleNodeIndex = chordIdToIndex[responsibleChordId];
+            
+            NS_LOG_LOGIC("File " << fileId << " - Nodo di partenza: " << startNodeIndex 
+                         << " (ChordID: " << nodes[startNodeIndex].chordId << ")"
+                         << " - Nodo responsabile: " << responsibleNodeIndex 
+                         << " (ChordID: " << responsibleChordId << ")");
+
+            if (analytic) {
+                Simulator::Schedule(startTime + Seconds(0.1 * i) + AnalyticDelay(startNodeIndex, responsibleNodeIndex),
+                                    &ChordNetwork::AnalyticStore, this, responsibleNodeIndex, fileId);
+                continue;
+            }
+            
+            if (startNodeIndex >= applications.size() || responsibleNodeIndex >= nodes.size()) {
+                NS_LOG_ERROR("Indice nodo non valido in InsertFiles");
+                continue;
+            }
+
+            Address targetAddr;
+            if (!directory->Lookup(responsibleChordId, targetAddr) || targetAddr.IsInvalid()) {
+                NS_LOG_ERROR("Indirizzo target non valido per il nodo " << responsibleNodeIndex);
+                continue;
+            }
+
+            uint32_t sNodeIndex = startNodeIndex;
+            ChordId fId = fileId;
+            Address tAddr = targetAddr;
+
+            auto sendStoreMessage = [this, sNodeIndex, fId, tAddr]() {
+                if (sNodeIndex >= applications.size() || !applications[sNodeIndex]) {
+                    NS_LOG_ERROR("Puntatore applicazione non valido");
+                    return;
+                }
+                if (!IsLocal(sNodeIndex)) {
+                    return;
+                }
+                
+                ChordMessage msg;
+                msg.type = ChordMessage::STORE_FILE;
+                msg.senderId = nodes[sNodeIndex].chordId;
+                msg.originId = nodes[sNodeIndex].chordId;   
+                msg.targetId = fId;
+                msg.hopCount = 0;
+                msg.success = false;
+
+                Ptr<Packet> packet = CreateMessagePacket(msg);
+                if (packet && applications[sNodeIndex]->IsStarted()) {
+                    applications[sNodeIndex]->SendMessage(packet, tAddr);
+                    NS_LOG_DEBUG("Inviato messaggio STORE_FILE per file " << fId 
+                                 << " dal nodo " << sNodeIndex << " (ChordID: " << nodes[sNodeIndex].chordId << ")"
+                                 << " al nodo responsabile");
+                } else {
+                    NS_LOG_ERROR("Failed to create packet or application not started");
+                }
+            };
+
+            Simulator::Schedule(startTime + Seconds(0.1 * i), sendStoreMessage);
+        }
+    }
+
+    void SimulateNodeFailures() {
+        Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable>();
+        
+        Time startTime = Seconds(5.0);
+        
+        std::set<uint32_t> failedNodes;
+        
+        for (uint32_t i = 0; i < failingNodes; i++) {
+            uint32_t nodeIndex;
+            bool validNode = false;
+
+            while (!validNode) {
+                nodeIndex = rng->GetInteger(0, numNodes - 1);
+                if (nodes[nodeIndex].isAlive && failedNodes.find(nodeIndex) == failedNodes.end()) {
+                    validNode = true;
+                    failedNodes.insert(nodeIndex);
+                }
+            }
+            
+            uint32_t nIndex = nodeIndex;
+            
+            auto setNodeDown = [this, nIndex]() {
+                if (nIndex < nodes.size()) {
+                    nodes[nIndex].isAlive = false;
+                    nodes[nIndex].failed = true;
+                    ring.Remove(nodes[nIndex].chordId);
+                    if (nIndex < applications.size()) {
+                        applications[nIndex]->SetAlive(false);
+                    }
+                    NS_LOG_INFO("Simulando fallimento del nodo " << nIndex);
+                }
+            };
+            
+            Time failureTime = startTime + Seconds(rng->GetValue(0.0, 5.0));
+            Simulator::Schedule(failureTime, setNodeDown);
+        }
+    }
+
+    void PerformLookups() {
+        if (config.arrival != "fixed") {
+            StartOpenLoopWorkload(Seconds(10.0));
+            return;
+        }
+
+        Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable>();
+        
+        Time startTime = Seconds(10.0);
+        
+        uint32_t totalAttempts = 0;
+        uint32_t skippedDeadNodes = 0;
+        
+        for (uint32_t i = 0; i < filesForLookup.size(); i++) {
+            ChordId fileId = filesForLookup[i];
+            uint32_t startNodeIndex = rng->GetInteger(0, numNodes - 1);
+            
+            totalAttempts++;
+            
+            if (!analytic && (startNodeIndex >= applications.size() || !applications[startNodeIndex])) {
+                NS_LOG_ERROR("Indice nodo non valido in PerformLookups: " << startNodeIndex);
+                continue;
+            }
+            
+            if (!nodes[startNodeIndex].isAlive) {
+                NS_LOG_INFO("Skippo una lookup da un nodo down " << startNodeIndex 
+                            << " (ChordID: " << nodes[startNodeIndex].chordId << ")"
+                            << " per il file " << fileId);
+                skippedDeadNodes++;
+                continue;
+            }
+            
+            uint32_t sNodeIndex = startNodeIndex;
+            ChordId fId = fileId;
+            uint32_t lookupId = ChordApplication::nextLookupId++;
+
+            auto startLookup = [this, sNodeIndex, fId, lookupId]() {
+                NS_LOG_INFO("Inizio lookup " << lookupId << " dal nodo " << sNodeIndex 
+                            << " (ChordID: " << nodes[sNodeIndex].chordId << ")"
+                            << " per il file " << fId);
+                if (StartLookup(sNodeIndex, fId, lookupId)) {
+                    stats.totalLookups++;
+                }
+            };
+
+            Simulator::Schedule(startTime + Seconds(0.1 * i), startLookup);
+        }
+
+        measureStart = startTime;
+        measureEnd = startTime + Seconds(0.1 * filesForLookup.size());
+        ScheduleStop(measureEnd);
+        
+        cout << "INFO: Statistiche lookup:" << endl;
+        cout << "  Tentativi totali: " << totalAttempts << endl;
+        cout << "  Tentativi saltati a causa di nodi down: " << skippedDeadNodes << endl;
+    }
+
+    // Con i protocolli di manutenzione attivi restano sempre eventi in coda: la simulazione
+    // si ferma quando anche l'ultimo lookup del workload è concluso o scaduto
+    void ScheduleStop(Time workloadEnd) {
+        Time joinsDone = joinEnd + Seconds(ChordApplication::JOIN_RETRY_INTERVAL * ChordApplication::MAX_JOIN_ATTEMPTS);
+        Time end = std::max(workloadEnd + timeoutDuration, config.joiningNodes > 0 ? joinsDone : Seconds(0));
+        Simulator::Stop(end - Simulator::Now() + Seconds(1.0));
+    }
+
+    // Ogni nodo di un'ondata entra tramite un bootstrap scelto a caso tra i nodi attivi
+    void ScheduleJoins() {
+        uint32_t wave = std::max(config.joinWave, (uint32_t)1);
+        for (uint32_t i = numNodes; i < totalNodes; i++) {
+            Time joinTime = Seconds(config.joinStart + config.joinInterval * ((i - numNodes) / wave));
+            Simulator::Schedule(joinTime, &ChordNetwork::JoinNode, this, i);
+            joinEnd = std::max(joinEnd, joinTime);
+        }
+    }
+
+    void JoinNode(uint32_t nodeIndex) {
+        if (ring.Empty()) {
+            NS_LOG_WARN("Nessun nodo attivo da usare come bootstrap per il nodo " << nodeIndex);
+            stats.failedJoins++;
+            return;
+        }
+        Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable>();
+        ChordId bootstrap = ring.At(rng->GetInteger(0, ring.Size() - 1));
+        applications[nodeIndex]->Join(bootstrap);
     }
 
-    void initializeNetwork() {
-        createPhysicalNetwork();
-        
+    void OnJoinCompleted(ChordId chordId, Time latency, bool success) {
+        uint32_t nodeIndex = chordIdToIndex[chordId];
+        bool rejoin = !rejoining.empty() && rejoining[nodeIndex];
+        if (!success) {
+            if (rejoin) {
+                // Nuovo tentativo dopo un altro periodo di assenza
+                Simulator::Schedule(SampleChurnTime(config.downTime), &ChordNetwork::RejoinNode, this, nodeIndex);
+            } else {
+                stats.failedJoins++;
+            }
+            return;
+        }
+        if (rejoin) {
+            rejoining[nodeIndex] = false;
+            stats.churnRejoins++;
+            timeSeries.rejoins++;
+        } else {
+            stats.joinedNodes++;
+        }
+        stats.joinLatency.Record(latency);
+        ring.Insert(chordId);
+        nodes[nodeIndex].isAlive = true;
+        if (config.churn != "none") {
+            Simulator::Schedule(SampleChurnTime(config.sessionTime), &ChordNetwork::DepartNode, this, nodeIndex);
+        }
+    }
+
+    // Durata di una sessione o di un'assenza con la media richiesta
+    Time SampleChurnTime(double mean) {
+        if (config.churn == "pareto") {
+            double scale = mean * (config.churnShape - 1) / config.churnShape;
+            return Seconds(churnPareto->GetValue(scale, config.churnShape, 0));
+        }
+        if (config.churn == "weibull") {
+            double scale = mean / std::tgamma(1 + 1 / config.churnShape);
+            return Seconds(churnWeibull->GetValue(scale, config.churnShape, 0));
+        }
+        return Seconds(churnExp->GetValue(mean, 0));
+    }
+
+    // Ogni nodo iniziale parte con una sessione attiva; i nodi entrati ricevono la loro
+    // prima sessione al termine della JOIN
+    void StartChurn() {
+        churnExp = CreateObject<ExponentialRandomVariable>();
+        churnPareto = CreateObject<ParetoRandomVariable>();
+        churnWeibull = CreateObject<WeibullRandomVariable>();
+        churnRng = CreateObject<UniformRandomVariable>();
+        rejoining.assign(totalNodes, false);
         for (uint32_t i = 0; i < numNodes; i++) {
-            initializeFingerTable(i);
-            initializeSuccessorList(i);
+            Time departure = Seconds(config.churnStart) + SampleChurnTime(config.sessionTime);
+            Simulator::Schedule(departure, &ChordNetwork::DepartNode, this, i);
         }
+    }
 
-        createChordApplications();
+    void DepartNode(uint32_t nodeIndex) {
+        if (!nodes[nodeIndex].isAlive) {
+            return;
+        }
+        NS_LOG_INFO("Churn: il nodo " << nodeIndex << " (ChordID: " << nodes[nodeIndex].chordId << ") esce dall'anello");
+        nodes[nodeIndex].isAlive = false;
+        ring.Remove(nodes[nodeIndex].chordId);
+        applications[nodeIndex]->SetAlive(false);
+        stats.churnDepartures++;
+        timeSeries.departures++;
+        Simulator::Schedule(SampleChurnTime(config.downTime), &ChordNetwork::RejoinNode, this, nodeIndex);
+    }
 
-        Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable>();
-        for (uint32_t i = 0; i < numFiles; i++) {
-            uint32_t fileId = rng->GetInteger(0, (1 << m) - 1);
-            files.push_back(fileId);
+    void RejoinNode(uint32_t nodeIndex) {
+        if (nodes[nodeIndex].failed) {
+            return;
+        }
+        rejoining[nodeIndex] = true;
+        if (ring.Empty()) {
+            // Anello vuoto: il nodo riparte da solo e fa da bootstrap per gli altri
+            applications[nodeIndex]->Restart(nodes[nodeIndex].chordId);
+            OnJoinCompleted(nodes[nodeIndex].chordId, Seconds(0), true);
+            return;
         }
+        ChordId bootstrap = ring.At(churnRng->GetInteger(0, ring.Size() - 1));
+        NS_LOG_INFO("Churn: il nodo " << nodeIndex << " rientra tramite il nodo " << bootstrap);
+        applications[nodeIndex]->Restart(bootstrap);
     }
 
-    void StartSimulation() {
-        cout << "Startando la simulazione Chord con " << numNodes << " nodi" << endl;
-        cout << "Fase 1: Inserimento di " << numFiles << " file" << endl;
-        InsertFiles();
+    void StartTimeSeries() {
+        timeSeriesOut.open(config.timeSeriesFile);
+        if (!timeSeriesOut.is_open()) {
+            cout << "ERRORE: Impossibile aprire il file " << config.timeSeriesFile << " per la scrittura" << endl;
+            return;
+        }
+        timeSeriesOut << "TimeS,LiveNodes,CompletedLookups,SuccessfulLookups,FailedLookups,TimedOutLookups,SuccessRate,"
+                      << "LatencyMeanMs,LatencyP50Ms,LatencyP99Ms,Departures,Rejoins" << endl;
+        Simulator::Schedule(Seconds(config.timeSeriesInterval), &ChordNetwork::SampleTimeSeries, this);
+    }
 
-        cout << "Fase 2: Simulazione di " << failingNodes << " nodi che falliscono" << endl;
-        SimulateNodeFailures();
+    void SampleTimeSeries() {
+        const TimeSeriesBucket& b = timeSeries;
+        timeSeriesOut << Simulator::Now().GetSeconds() << ","
+                      << ring.Size() << ","
+                      << b.completed << ","
+                      << b.successful << ","
+                      << b.completed - b.successful << ","
+                      << b.timedOut << ","
+                      << (b.completed > 0 ? (float)b.successful / b.completed * 100 : 0) << ","
+                      << b.latency.MeanMs() << ","
+                      << b.latency.PercentileMs(0.5) << ","
+                      << b.latency.PercentileMs(0.99) << ","
+                      << b.departures << ","
+                      << b.rejoins << endl;
+        timeSeries.completed = 0;
+        timeSeries.successful = 0;
+        timeSeries.timedOut = 0;
+        timeSeries.departures = 0;
+        timeSeries.rejoins = 0;
+        timeSeries.latency.Reset();
+        Simulator::Schedule(Seconds(config.timeSeriesInterval), &ChordNetwork::SampleTimeSeries, this);
+    }
 
-        PrepareFilesToLookup();
+    // Contatori per nodo e per tipo di messaggio: una riga per ogni tipo con traffico più una riga
+    // ALL con i totali del nodo; le istantanee periodiche riportano i valori cumulativi
+    void StartNodeStats() {
+        nodeStatsOut.open(config.nodeStatsFile);
+        if (!nodeStatsOut.is_open()) {
+            cout << "ERRORE: Impossibile aprire il file " << config.nodeStatsFile << " per la scrittura" << endl;
+            return;
+        }
+        nodeStatsOut << "TimeS,NodeIndex,ChordId,Alive,StoredKeys,Type,SentPackets,SentBytes,ReceivedPackets,"
+                     << "ReceivedBytes,Forwarded,Timeouts,Dropped" << endl;
+        if (config.nodeStatsInterval > 0) {
+            Simulator::Schedule(Seconds(config.nodeStatsInterval), &ChordNetwork::SampleNodeStats, this);
+        }
+    }
 
-        cout << "Fase 3: Esecuzione di " << numLookups << " lookup" << endl;
-        PerformLookups();
+    void SampleNodeStats() {
+        WriteNodeStatsSnapshot();
+        Simulator::Schedule(Seconds(config.nodeStatsInterval), &ChordNetwork::SampleNodeStats, this);
     }
 
-    void PrintStatistics() {
-        cout << "===========================================" << endl;
-        cout << "SIMULAZIONE CHORD - STATISTICHE FINALI" << endl;
-        cout << "===========================================" << endl;
-        cout << "Parametri di simulazione:" << endl;
-        cout << "  Numero di nodi: " << numNodes << endl;
-        cout << "  Numero di file inseriti: " << numFiles << endl;
-        cout << "  Numero di lookup eseguiti: " << numLookups << endl;
-        cout << "  Nodi che hanno fallito: " << failingNodes << " (" << (float)failingNodes/numNodes*100 << "%)" << endl;
-        cout << "===========================================" << endl;
-        cout << "Risultati dei lookup:" << endl;
-        cout << "  Totale lookup eseguiti: " << stats.totalLookups << endl;
-        cout << "  Lookup riusciti: " << stats.successfulLookups << " (" << 
-            (stats.totalLookups > 0 ? (float)stats.successfulLookups/stats.totalLookups*100 : 0) << "%)" << endl;
-        cout << "  Lookup falliti: " << stats.failedLookups << " (" << 
-            (stats.totalLookups > 0 ? (float)stats.failedLookups/stats.totalLookups*100 : 0) << "%)" << endl;
-        
-        if (stats.successfulLookups > 0) {
-            cout << "  Media hop per lookup riuscito: " << (float)stats.averageHops / stats.successfulLookups << endl;
-            cout << "  Minimo hop per lookup riuscito: " << stats.minHops << endl;
-            cout << "  Massimo hop per lookup riuscito: " << stats.maxHops << endl;
-            cout << "  Media teorica (log2(N)): " << log2(numNodes) << endl;
-        } else {
-            cout << "  Media/Min/Max hop: N/A (nessun lookup riuscito)" << endl;
+    void WriteNodeStatsSnapshot() {
+        double now = Simulator::Now().GetSeconds();
+        for (uint32_t i = 0; i < applications.size(); i++) {
+            const Ptr<ChordApplication>& app = applications[i];
+            const std::vector<MessageCounters>& counters = app->GetMessageCounters();
+            MessageCounters total;
+            for (uint32_t type = 0; type < counters.size(); type++) {
+                const MessageCounters& c = counters[type];
+                total.Add(c);
+                if (c.sentPackets + c.receivedPackets + c.timeouts + c.dropped == 0) {
+                    continue;
+                }
+                WriteNodeStatsRow(now, i, GetMessageTypeName((ChordMessage::MessageType)type), c);
+            }
+            WriteNodeStatsRow(now, i, "ALL", total);
         }
-        cout << "===========================================" << endl;
     }
-    
-    void WriteStatisticsToCSV(const std::string& filename) {
-        std::ofstream csvFile;
-        csvFile.open(filename);
-        
-        if (!csvFile.is_open()) {
-            cout << "ERRORE: Impossibile aprire il file " << filename << " per la scrittura" << endl;
+
+    void WriteNodeStatsRow(double now, uint32_t nodeIndex, const std::string& type, const MessageCounters& c) {
+        const Ptr<ChordApplication>& app = applications[nodeIndex];
+        nodeStatsOut << now << ","
+                     << nodeIndex << ","
+                     << app->GetChordId() << ","
+                     << (app->IsAlive() ? 1 : 0) << ","
+                     << app->GetStoredKeys() << ","
+                     << type << ","
+                     << c.sentPackets << ","
+                     << c.sentBytes << ","
+                     << c.receivedPackets << ","
+                     << c.receivedBytes << ","
+                     << c.forwarded << ","
+                     << c.timeouts << ","
+                     << c.dropped << endl;
+    }
+
+    // Generatore open-loop: ogni arrivo pianifica il successivo, indipendentemente dal
+    // completamento dei lookup in corso, quindi il carico offerto non dipende dalla latenza
+    void StartOpenLoopWorkload(Time startTime) {
+        workloadRng = CreateObject<UniformRandomVariable>();
+        arrivalRng = CreateObject<ExponentialRandomVariable>();
+        workloadStart = startTime;
+        measureStart = startTime + Seconds(config.warmup);
+        measureEnd = config.duration > 0 ? measureStart + Seconds(config.duration) : Time::Max();
+        firstMeasuredLookupId = UINT32_MAX;
+        if (config.duration <= 0 && numLookups == 0) {
+            ScheduleStop(startTime);
             return;
         }
-        
-        csvFile << "NumNodes,NumFiles,NumLookups,FailingNodes,TotalLookups,SuccessfulLookups,FailedLookups,SuccessRate,AverageHops,MinHops,MaxHops,TheoreticalAverage" << endl;
-        
-        float successRate = stats.totalLookups > 0 ? (float)stats.successfulLookups/stats.totalLookups*100 : 0;
-        float averageHops = stats.successfulLookups > 0 ? (float)stats.averageHops / stats.successfulLookups : 0;
-        float theoreticalAverage = log2(numNodes);
-        
-        csvFile << numNodes << ","
-                << numFiles << ","
-                << numLookups << ","
-                << failingNodes << ","
-                << stats.totalLookups << ","
-                << stats.successfulLookups << ","
-                << stats.failedLookups << ","
-                << successRate << ","
-                << averageHops << ","
-                << (stats.successfulLookups > 0 ? stats.minHops : 0) << ","
-                << (stats.successfulLookups > 0 ? stats.maxHops : 0) << ","
-                << theoreticalAverage << endl;
-        
-        csvFile.close();
-        cout << "Statistiche scritte nel file " << filename << endl;
+
+        cout << "INFO: Workload " << config.arrival << " a " << config.rate << " lookup/s"
+             << " (warm-up " << config.warmup << "s, misura "
+             << (config.duration > 0 ? std::to_string(config.duration) + "s" : std::to_string(numLookups) + " lookup")
+             << ")" << endl;
+
+        Simulator::Schedule(startTime + NextInterarrival(startTime), &ChordNetwork::GenerateLookup, this);
     }
 
-    void UpdateStats(bool success, uint32_t hops, uint32_t lookupId) {
-        if (processedLookups.find(lookupId) != processedLookups.end()) {
-            cout << "WARN: Lookup " << lookupId << " already processed, ignoring duplicate" << endl;
-            return;
+    // Tempo fino al prossimo arrivo a partire da now, secondo il processo configurato
+    Time NextInterarrival(Time now) {
+        double meanGap = 1.0 / config.rate;
+        if (config.arrival == "constant") {
+            return Seconds(meanGap);
         }
-        
-        processedLookups.insert(lookupId);
-        
-        if (success) {
-            stats.successfulLookups++;
-            stats.averageHops += hops;
-            
-            if (hops < stats.minHops) {
-                stats.minHops = hops;
+        if (config.arrival == "poisson") {
+            return Seconds(arrivalRng->GetValue(meanGap, 0));
+        }
+
+        // bursty: Poisson modulato on/off, con tasso nelle fasi attive scalato in modo che
+        // il tasso medio resti quello configurato
+        double period = config.burstOn + config.burstOff;
+        double onGap = meanGap * config.burstOn / period;
+        double t = (now - workloadStart).GetSeconds();
+        while (true) {
+            double phase = std::fmod(t, period);
+            if (phase >= config.burstOn) {
+                t += period - phase;   // in pausa: salta all'inizio della prossima fase attiva
+                continue;
             }
-            if (hops > stats.maxHops) {
-                stats.maxHops = hops;
+            double gap = arrivalRng->GetValue(onGap, 0);
+            if (phase + gap < config.burstOn) {
+                return Seconds(t + gap) + workloadStart - now;
             }
-            
-            cout << "Lookup " << lookupId << " riuscito dopo " << hops << " hop" << endl;
-        } else {
-            stats.failedLookups++;
-            cout << "Lookup " << lookupId << " fallito" << endl;
-        }
-        
-        cout << "DEBUG: Statistiche aggiornate:" << endl;
-        cout << "  Total Lookups: " << stats.totalLookups << endl;
-        cout << "  Successful Lookups: " << stats.successfulLookups << endl;
-        cout << "  Failed Lookups: " << stats.failedLookups << endl;
-        if (stats.successfulLookups > 0) {
-            cout << "  Average Hops: " << (float)stats.averageHops / stats.successfulLookups << endl;
-            cout << "  Min Hops: " << stats.minHops << endl;
-            cout << "  Max Hops: " << stats.maxHops << endl;
-        } else {
-            cout << "  Average/Min/Max Hops: N/A (no successful lookups)" << endl;
+            t += config.burstOn - phase;   // assenza di memoria: riparte dalla prossima fase attiva
         }
     }
 
-    void PrepareFilesToLookup() {
-        filesForLookup.clear();
-        
-        cout << "Preparazione di " << numLookups << " file da cercare tra i " << files.size() << " inseriti" << endl;
-        
-        if (numLookups >= numFiles) {
-            filesForLookup = files;
-            cout << "Cercheremo tutti i " << filesForLookup.size() << " file inseriti" << endl;
+    void GenerateLookup() {
+        Time now = Simulator::Now();
+        bool measured = now >= measureStart;
+        if (now >= measureEnd) {
+            ScheduleStop(now);
             return;
         }
-        
-        Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable>();
-        std::set<uint32_t> selectedIndices;  
-        
-        while (selectedIndices.size() < numLookups) {
-            uint32_t index = rng->GetInteger(0, numFiles - 1);
-            if (selectedIndices.find(index) == selectedIndices.end()) {
-                selectedIndices.insert(index);
-                filesForLookup.push_back(files[index]);
+        Simulator::Schedule(NextInterarrival(now), &ChordNetwork::GenerateLookup, this);
+
+        if (ring.Empty() || files.empty()) {
+            return;
+        }
+
+        // Nodo di partenza scelto uniformemente tra quelli attivi in questo istante
+        ChordId startChordId = ring.At(workloadRng->GetInteger(0, ring.Size() - 1));
+        uint32_t startNodeIndex = chordIdToIndex[startChordId];
+        ChordId fileId = config.popularity == "uniform" ? files[workloadRng->GetInteger(0, files.size() - 1)]
+                                                         : NextLookupKey();
+        uint32_t lookupId = ChordApplication::nextLookupId++;
+
+        if (measured) {
+            if (firstMeasuredLookupId == UINT32_MAX) {
+                firstMeasuredLookupId = lookupId;
+            }
+            measuredArrivals++;
+            if (IsLocal(startNodeIndex)) {
+                stats.totalLookups++;
+            }
+            if (config.duration <= 0 && measuredArrivals >= numLookups) {
+                measureEnd = now;
             }
         }
-        
-        cout << "Selezionati " << filesForLookup.size() << " file da cercare" << endl;
+
+        NS_LOG_INFO("Inizio lookup " << lookupId << " dal nodo " << startNodeIndex 
+                    << " (ChordID: " << startChordId << ") per il file " << fileId
+                    << (measured ? "" : " [warm-up]"));
+        StartLookup(startNodeIndex, fileId, lookupId);
     }
+};
 
+// Esecuzione di una campagna di simulazioni: ogni combinazione dei valori di --sweep viene ripetuta
+// --reps volte con seed diversi, ciascuna in un processo figlio (il simulatore di ns-3 è un singleton)
+// lanciato con gli stessi argomenti, al più jobs alla volta. Il processo padre raccoglie i CSV delle
+// singole esecuzioni e calcola media, deviazione standard e intervallo di confidenza al 95%
+class ChordSweep {
 private:
-    void createPhysicalNetwork() {
-        nsNodes.Create(numNodes);
-        
-        // Setup del routing
-        Ipv4NixVectorHelper nixRouting;
-        InternetStackHelper stackIP;
-        stackIP.SetRoutingHelper(nixRouting);
-        stackIP.Install(nsNodes);
+    struct Dimension {
+        std::string name;
+        std::vector<std::string> values;
+    };
 
-        PointToPointHelper p2p;
-        p2p.SetDeviceAttribute ("DataRate", StringValue ("10Mbps"));
-        p2p.SetChannelAttribute ("Delay", StringValue ("50ms"));
+    struct Run {
+        uint32_t config;        // indice della combinazione di parametri
+        uint32_t rep;
+        uint32_t seed;
+        std::string csvFile;
+        std::string logFile;
+        int exitCode;
+        std::vector<std::string> row;
+    };
 
-        Ipv4AddressHelper ipv4;
-        ipv4.SetBase ("10.0.0.0", "/30");
-        
-        Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable>();
-        std::set<uint32_t> usedIds; 
-        std::vector<uint32_t> chordIds(numNodes);
-        
-        cout << "DEBUG: Generazione di " << numNodes << " ChordID nello spazio 0.." << ((1 << m) - 1) << endl;
-        
-        for (uint32_t i = 0; i < numNodes; i++) {
-            uint32_t chordId;
-            do {
-                chordId = rng->GetInteger(0, (1 << m) - 1);
-            } while (usedIds.find(chordId) != usedIds.end());
-            
-            usedIds.insert(chordId);
-            chordIds[i] = chordId;
-            cout << "DEBUG: Nodo " << i << " ha ChordID " << chordId << endl;
+    std::vector<Dimension> dimensions;
+    std::vector<std::vector<std::string>> configs;  // valori di ogni combinazione, nell'ordine di dimensions
+    std::vector<std::string> baseArgs;
+    std::vector<Run> runs;
+    std::vector<std::string> header;
+    std::string directory;
+    uint32_t reps;
+    uint32_t baseSeed;
+    uint32_t jobs;
+
+    static std::vector<std::string> Split(const std::string& text, char separator) {
+        std::vector<std::string> parts;
+        std::stringstream ss(text);
+        std::string part;
+        while (std::getline(ss, part, separator)) {
+            if (!part.empty()) {
+                parts.push_back(part);
+            }
         }
-        
-        std::vector<std::pair<uint32_t, uint32_t>> nodeIdPairs;
-        for (uint32_t i = 0; i < numNodes; i++) {
-            nodeIdPairs.push_back(std::make_pair(chordIds[i], i));
+        return parts;
+    }
+
+    static bool ParseNumber(const std::string& text, double& value) {
+        char* end = nullptr;
+        value = std::strtod(text.c_str(), &end);
+        return !text.empty() && end == text.c_str() + text.size();
+    }
+
+    // Quantile 0.975 della t di Student; oltre 30 gradi di libertà l'approssimazione normale
+    static double StudentT(uint32_t degrees) {
+        static const double quantiles[] = {12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+                                           2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+                                           2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+        return degrees <= 30 ? quantiles[degrees - 1] : 1.96;
+    }
+
+    // Argomenti dell'esecuzione: quelli comuni, i valori della combinazione, seed e CSV propri
+    std::vector<std::string> RunArgs(const Run& run) const {
+        std::vector<std::string> args = baseArgs;
+        for (size_t d = 0; d < dimensions.size(); d++) {
+            args.push_back("--" + dimensions[d].name + "=" + configs[run.config][d]);
         }
-        std::sort(nodeIdPairs.begin(), nodeIdPairs.end());
-        
-        const uint32_t ringSize = std::min(numNodes, (uint32_t)10);
-        for (uint32_t i = 0; i < ringSize; i++) {
-            NetDeviceContainer dev = p2p.Install(nsNodes.Get(i), nsNodes.Get((i + 1) % ringSize));
-            ipv4.Assign(dev);
-            ipv4.NewNetwork();
-            
-            nodes.push_back(ChordNode(chordIds[i], nsNodes.Get(i)));
+        args.push_back("--seed=" + std::to_string(run.seed));
+        args.push_back("--csv=" + run.csvFile);
+        return args;
+    }
+
+    pid_t Launch(const Run& run) const {
+        std::vector<std::string> args = RunArgs(run);
+        unlink(run.csvFile.c_str());    // niente risultati di campagne precedenti
+        pid_t pid = fork();
+        if (pid != 0) {
+            return pid;
+        }
+        int log = open(run.logFile.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (log >= 0) {
+            dup2(log, STDOUT_FILENO);
+            dup2(log, STDERR_FILENO);
+            close(log);
+        }
+        std::vector<char*> argv;
+        for (const std::string& arg : args) {
+            argv.push_back(const_cast<char*>(arg.c_str()));
+        }
+        argv.push_back(nullptr);
+        execv("/proc/self/exe", argv.data());
+        _exit(127);
+    }
+
+    // Ultima riga del CSV di un'esecuzione; l'intestazione viene presa dalla prima esecuzione riuscita
+    bool ReadResult(Run& run) {
+        std::ifstream in(run.csvFile);
+        std::string headerLine;
+        std::string line;
+        if (!std::getline(in, headerLine)) {
+            return false;
+        }
+        std::string last;
+        while (std::getline(in, line)) {
+            if (!line.empty()) {
+                last = line;
+            }
+        }
+        if (last.empty()) {
+            return false;
+        }
+        if (header.empty()) {
+            header = Split(headerLine, ',');
+        }
+        run.row = Split(last, ',');
+        return run.row.size() == header.size();
+    }
+
+    std::string ConfigLabel(uint32_t config) const {
+        std::string label;
+        for (size_t d = 0; d < dimensions.size(); d++) {
+            label += (d > 0 ? " " : "") + dimensions[d].name + "=" + configs[config][d];
+        }
+        return label;
+    }
+
+    void WriteSamples() const {
+        std::ofstream out(directory + "/samples.csv");
+        for (const Dimension& dimension : dimensions) {
+            out << dimension.name << ",";
+        }
+        out << "Rep,Seed,ExitCode";
+        for (const std::string& column : header) {
+            out << "," << column;
+        }
+        out << endl;
+        for (const Run& run : runs) {
+            for (const std::string& value : configs[run.config]) {
+                out << value << ",";
+            }
+            out << run.rep << "," << run.seed << "," << run.exitCode;
+            for (size_t c = 0; c < header.size(); c++) {
+                out << "," << (c < run.row.size() ? run.row[c] : "");
+            }
+            out << endl;
+        }
+    }
+
+    // Una riga per combinazione e metrica numerica, calcolata sui campioni delle esecuzioni riuscite
+    void WriteSummary() const {
+        std::ofstream out(directory + "/summary.csv");
+        for (const Dimension& dimension : dimensions) {
+            out << dimension.name << ",";
+        }
+        out << "Metric,Runs,Mean,StdDev,CI95Low,CI95High" << endl;
+        for (uint32_t config = 0; config < configs.size(); config++) {
+            for (size_t c = 0; c < header.size(); c++) {
+                std::vector<double> samples;
+                bool numeric = true;
+                for (const Run& run : runs) {
+                    double value;
+                    if (run.config != config || run.row.empty()) {
+                        continue;
+                    }
+                    if (!ParseNumber(run.row[c], value)) {
+                        numeric = false;
+                        break;
+                    }
+                    samples.push_back(value);
+                }
+                if (!numeric || samples.empty()) {
+                    continue;
+                }
+                double mean = 0;
+                for (double value : samples) {
+                    mean += value;
+                }
+                mean /= samples.size();
+                double variance = 0;
+                for (double value : samples) {
+                    variance += (value - mean) * (value - mean);
+                }
+                double stddev = samples.size() > 1 ? std::sqrt(variance / (samples.size() - 1)) : 0;
+                double halfWidth = samples.size() > 1 ? StudentT(samples.size() - 1) * stddev / std::sqrt(samples.size()) : 0;
+                for (const std::string& value : configs[config]) {
+                    out << value << ",";
+                }
+                out << header[c] << "," << samples.size() << "," << mean << "," << stddev << ","
+                    << mean - halfWidth << "," << mean + halfWidth << endl;
+            }
+        }
+    }
+
+public:
+    ChordSweep(const std::string& spec, uint32_t repetitions, uint32_t seed, uint32_t parallelJobs, const std::string& dir)
+        : directory(dir), reps(repetitions), baseSeed(seed), jobs(parallelJobs) {
+        for (const std::string& part : Split(spec, ';')) {
+            size_t eq = part.find('=');
+            Dimension dimension;
+            dimension.name = part.substr(0, eq);
+            if (eq != std::string::npos) {
+                dimension.values = Split(part.substr(eq + 1), ',');
+            }
+            dimensions.push_back(dimension);
+        }
+        if (jobs == 0) {
+            jobs = std::max(1u, std::thread::hardware_concurrency());
+        }
+    }
+
+    // Controlla la specifica e conserva gli argomenti comuni a tutte le esecuzioni
+    bool Prepare(int argc, char* argv[]) {
+        if (dimensions.empty() || reps == 0) {
+            cout << "ERRORE: --sweep deve contenere almeno un parametro e --reps essere almeno 1" << endl;
+            return false;
+        }
+        for (const Dimension& dimension : dimensions) {
+            if (dimension.name.empty() || dimension.values.empty() || dimension.name == "seed"
+                || dimension.name == "csv" || dimension.name.compare(0, 5, "sweep") == 0) {
+                cout << "ERRORE: dimensione di --sweep non valida: " << dimension.name
+                     << " (formato nome=v1,v2;nome=v1,...; seed e csv sono gestiti dalla campagna)" << endl;
+                return false;
+            }
+        }
+        static const char* const own[] = {"--sweep", "--reps=", "--jobs=", "--seed=", "--csv="};
+        baseArgs.push_back(argv[0]);
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            bool skip = false;
+            for (const char* prefix : own) {
+                skip = skip || arg.compare(0, strlen(prefix), prefix) == 0;
+            }
+            for (const Dimension& dimension : dimensions) {
+                skip = skip || arg.compare(0, dimension.name.size() + 3, "--" + dimension.name + "=") == 0;
+            }
+            if (!skip) {
+                baseArgs.push_back(arg);
+            }
+        }
+
+        configs.assign(1, std::vector<std::string>());
+        for (const Dimension& dimension : dimensions) {
+            std::vector<std::vector<std::string>> expanded;
+            for (const std::vector<std::string>& config : configs) {
+                for (const std::string& value : dimension.values) {
+                    expanded.push_back(config);
+                    expanded.back().push_back(value);
+                }
+            }
+            configs.swap(expanded);
+        }
+        mkdir(directory.c_str(), 0755);
+        for (uint32_t config = 0; config < configs.size(); config++) {
+            for (uint32_t rep = 0; rep < reps; rep++) {
+                Run run;
+                run.config = config;
+                run.rep = rep + 1;
+                run.seed = baseSeed + rep;
+                std::string name = directory + "/c" + std::to_string(config) + "_r" + std::to_string(run.rep);
+                run.csvFile = name + ".csv";
+                run.logFile = name + ".log";
+                run.exitCode = -1;
+                runs.push_back(run);
+            }
+        }
+        return true;
+    }
+
+    // Esegue tutte le simulazioni con al più jobs processi contemporanei; restituisce le esecuzioni fallite
+    uint32_t Execute() {
+        cout << "Campagna di " << runs.size() << " simulazioni (" << configs.size() << " configurazioni x "
+             << reps << " ripetizioni) su " << jobs << " processi, risultati in " << directory << endl;
+        std::map<pid_t, size_t> running;
+        size_t next = 0;
+        size_t done = 0;
+        uint32_t failed = 0;
+        while (done < runs.size()) {
+            while (running.size() < jobs && next < runs.size()) {
+                pid_t pid = Launch(runs[next]);
+                if (pid < 0) {
+                    cout << "ERRORE: impossibile avviare la simulazione " << next << endl;
+                    runs[next].exitCode = 127;
+                    failed++;
+                    done++;
+                } else {
+                    running[pid] = next;
+                }
+                next++;
+            }
+            if (running.empty()) {
+                continue;
+            }
+            int status = 0;
+            pid_t pid = waitpid(-1, &status, 0);
+            auto it = running.find(pid);
+            if (it == running.end()) {
+                continue;
+            }
+            Run& run = runs[it->second];
+            running.erase(it);
+            done++;
+            run.exitCode = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+            bool ok = run.exitCode == 0 && ReadResult(run);
+            if (!ok) {
+                run.row.clear();
+                failed++;
+            }
+            cout << "[" << done << "/" << runs.size() << "] " << ConfigLabel(run.config) << " rep " << run.rep
+                 << (ok ? ": ok" : ": FALLITA (vedi " + run.logFile + ")") << endl;
         }
+        WriteSamples();
+        WriteSummary();
+        cout << "Campioni in " << directory << "/samples.csv, riepilogo in " << directory << "/summary.csv" << endl;
+        return failed;
+    }
+};
 
-        Ptr<UniformRandomVariable> r = CreateObject<UniformRandomVariable>();
-        for (uint32_t i = ringSize; i < numNodes; i++) {
-            vector<bool> link(numNodes, false);
-            uint32_t numLinks = 0;
-            uint32_t minLinks = 3;
+// Microbenchmark delle primitive di instradamento e di contabilità, senza simulatore.
+// Ricerca del prossimo hop: per ogni m un anello sintetico di nodes nodi con tabelle esatte e lookup
+// completi, dall'origine fino al responsabile. I percorsi sono calcolati una volta e poi ripercorsi
+// misurando solo le scelte del prossimo hop, con la scansione lineare della finger table (la regola
+// originale, per confronto) e con FlatFingerTable.
+// Primitive: findSuccessor, initializeFingerTable, FindNextHop e UpdateStats di una ChordNetwork con
+// il motore analitico da 1000 a 100000 nodi, IsInRange e serializzazione e deserializzazione
+// dell'header. I risultati possono essere salvati in CSV e confrontati con una baseline: un tempo
+// per operazione oltre la tolleranza è una regressione
+class ChordBench {
+private:
+    struct BenchNode {
+        ChordId id;
+        std::vector<ChordId> fingers;
+        FlatFingerTable flat;
+        std::vector<ChordId> successors;
+    };
 
-            nodes.push_back(ChordNode(chordIds[i], nsNodes.Get(i)));
+    struct Result {
+        std::string name;
+        uint32_t param;         // m, numero di nodi o di identificatori nel messaggio
+        double nsPerOp;
+    };
 
-            while (numLinks < minLinks) {
-                uint32_t j = r->GetInteger((i - ringSize) / 3 * 2, i - 1);
-                if ((j == i) || link[j]) {
-                    continue;
-                }
-                link[j] = true;
-                NetDeviceContainer dev = p2p.Install(nsNodes.Get(i), nsNodes.Get(j));
-                ipv4.Assign(dev);
-                ipv4.NewNetwork();
-                numLinks++;
-            }
-        }
-        
-        cout << "DEBUG: ChordID generati: ";
-        for (uint32_t i = 0; i < nodes.size(); i++) {
-            cout << nodes[i].chordId << " ";
-        }
-        cout << endl;
+    uint32_t numNodes;
+    uint32_t numLookups;
+    uint32_t repetitions;       // passate misurate dopo il riscaldamento; conta la più veloce
+    Ptr<UniformRandomVariable> rng;
+    std::vector<Result> results;
+    uint64_t checksum;          // dipende da ogni operazione misurata, così nessun ciclo viene eliminato
+
+    void Record(const std::string& name, uint32_t param, double nsPerOp) {
+        results.push_back({name, param, nsPerOp});
+        cout << "  " << std::left << std::setw(28) << name << std::right << std::setw(8) << param
+             << std::setw(14) << std::fixed << std::setprecision(1) << nsPerOp << " ns/op" << endl;
     }
 
-    void initializeFingerTable(uint32_t nodeIndex) {
-        ChordNode& node = nodes[nodeIndex];
-        node.fingerTable.clear();
-        
-        cout << "DEBUG: Inizializzazione finger table per nodo " << nodeIndex << " con ChordID " << node.chordId << endl;
-        
-        for (uint32_t i = 0; i < m; i++) {
-            uint32_t fingerStart = (node.chordId + (1 << i)) % (1 << m);
-            uint32_t successor = findSuccessor(fingerStart);
-            node.fingerTable.push_back(successor);
-            cout << "DEBUG: Finger " << i << " per nodo " << node.chordId << ": start=" << fingerStart << ", successor=" << successor << endl;
+    // Nanosecondi per operazione della passata più veloce tra repetitions, dopo una di riscaldamento
+    template <typename Body>
+    double Measure(uint64_t ops, Body body) const {
+        body();
+        double best = std::numeric_limits<double>::max();
+        for (uint32_t r = 0; r < repetitions; r++) {
+            best = std::min(best, TimePass(body));
         }
+        return best / std::max<uint64_t>(ops, 1);
     }
 
-    void initializeSuccessorList(uint32_t nodeIndex) {
-        ChordNode& node = nodes[nodeIndex];
-        node.successorList.clear();
-        
-        cout << "DEBUG: Inizializzazione successor list per nodo " << nodeIndex << " con ChordID " << node.chordId << endl;
-        
-        std::vector<uint32_t> sortedChordIds;
-        for (const ChordNode& n : nodes) {
-            sortedChordIds.push_back(n.chordId);
+    // Anello di n nodi con ID distinti nello spazio di m bit, ordinati per ID
+    std::vector<BenchNode> BuildRing(uint32_t m, uint32_t n) const {
+        std::set<ChordId> used;
+        while (used.size() < n) {
+            used.insert(RandomId(rng, m));
         }
-        std::sort(sortedChordIds.begin(), sortedChordIds.end());
-        
-        auto it = std::find(sortedChordIds.begin(), sortedChordIds.end(), node.chordId);
-        if (it == sortedChordIds.end()) {
-            cout << "ERROR: ChordID " << node.chordId << " non trovato nell'array ordinato!" << endl;
-            return;
+        std::vector<ChordId> ids(used.begin(), used.end());
+        auto successorOf = [&](ChordId id) {
+            auto it = std::lower_bound(ids.begin(), ids.end(), id);
+            return it == ids.end() ? ids.front() : *it;
+        };
+        std::vector<BenchNode> ring(n);
+        for (uint32_t i = 0; i < n; i++) {
+            BenchNode& node = ring[i];
+            node.id = ids[i];
+            for (uint32_t k = 0; k < m; k++) {
+                node.fingers.push_back(successorOf(IdAdd(node.id, IdPow2(k), m)));
+            }
+            node.flat.Build(node.id, node.fingers, m);
+            for (uint32_t k = 1; k <= 3 && k < n; k++) {
+                node.successors.push_back(ids[(i + k) % n]);
+            }
         }
-        
-        size_t pos = std::distance(sortedChordIds.begin(), it);
-        
-        size_t successorPos = (pos + 1) % sortedChordIds.size();
-        node.successorList.push_back(sortedChordIds[successorPos]);
-        cout << "DEBUG: Successore per nodo " << node.chordId << ": " << sortedChordIds[successorPos] << endl;
+        return ring;
     }
 
-    uint32_t findSuccessor(uint32_t id) {
-        cout << "DEBUG: findSuccessor per id " << id << endl;
-        
-        if (nodes.empty()) {
-            cout << "DEBUG: Nessun nodo nella rete!" << endl;
-            return 0;
+    // La regola di SelectNextHop con la scansione dei finger dal più lontano
+    static ChordId ScanNextHop(const BenchNode& node, ChordId targetId, bool& isOwner) {
+        isOwner = false;
+        ChordId successor = node.successors.empty() ? node.id : node.successors[0];
+        if (targetId == node.id || successor == node.id) {
+            return node.id;
         }
-        
-        std::vector<uint32_t> sortedChordIds;
-        for (const ChordNode& node : nodes) {
-            sortedChordIds.push_back(node.chordId);
+        if (IsInRingRange(targetId, node.id, successor)) {
+            isOwner = true;
+            return successor;
         }
-        std::sort(sortedChordIds.begin(), sortedChordIds.end());
-        
-        for (uint32_t chordId : sortedChordIds) {
-            if (chordId >= id) {
-                cout << "DEBUG: findSuccessor ha trovato il nodo " << chordId << " per id " << id << endl;
-                return chordId;
+        ChordId best = successor;
+        for (int i = node.fingers.size() - 1; i >= 0; i--) {
+            ChordId finger = node.fingers[i];
+            if (finger != node.id && IsInRingRange(finger, node.id, targetId)) {
+                best = finger;
+                break;
             }
         }
-        
-        cout << "DEBUG: findSuccessor non ha trovato nodi con id >= " << id << ", ritorna il primo nodo " << sortedChordIds[0] << endl;
-        return sortedChordIds[0];
-    }
-
-    void createChordApplications() {
-        for (uint32_t i = 0; i < numNodes; i++) {
-            Ptr<ChordApplication> app = CreateObject<ChordApplication>();
-            nsNodes.Get(i)->AddApplication(app);
-            app->Setup(nodes[i].chordId, nodes[i].fingerTable, nodes[i].successorList, nodes[i].predecessor);
-            
-            for (uint32_t j = 0; j < numNodes; j++) {
-                app->AddNodeAddress(nodes[j].chordId, getNodeAddress(j));
+        for (ChordId id : node.successors) {
+            if (id != node.id && IsInRingRange(id, best, targetId)) {
+                best = id;
             }
-            
-            app->SetStatsCallback(MakeCallback(&ChordNetwork::UpdateStats, this));
-            
-            applications.push_back(app);
         }
+        isOwner = best == targetId;
+        return best;
     }
 
-    Address getNodeAddress(uint32_t nodeId) {
-        if (nodeId >= nodes.size() || !nodes[nodeId].nsNode) {
-            cout << "ERROR: ID nodo non valido o puntatore nodo nullo: " << nodeId << endl;
-            return Address();
-        }
-
-        Ptr<Ipv4> ipv4 = nodes[nodeId].nsNode->GetObject<Ipv4>();
-        if (!ipv4) {
-            cout << "ERROR: Nessun stack IPv4 sul nodo: " << nodeId << endl;
-            return Address();
-        }
+    static ChordId FlatNextHop(const BenchNode& node, ChordId targetId, bool& isOwner) {
+        return SelectNextHop(node.id, targetId, node.flat, node.successors, [](ChordId) { return true; }, isOwner);
+    }
 
-        if (ipv4->GetNInterfaces() <= 1) {
-            cout << "ERROR: Nessuna interfaccia di rete sul nodo: " << nodeId << endl;
-            return Address();
+    // Hop (indice del nodo, target) di un lookup da origin verso targetId; falso se a un hop le due
+    // ricerche scelgono nodi diversi
+    static bool TraceLookup(const std::vector<BenchNode>& ring, uint32_t origin, ChordId targetId,
+                            std::vector<std::pair<uint32_t, ChordId>>& hops) {
+        uint32_t current = origin;
+        for (uint32_t hop = 0; hop < ChordApplication::MAX_LOOKUP_HOPS; hop++) {
+            bool owner = false;
+            bool scanOwner = false;
+            ChordId next = FlatNextHop(ring[current], targetId, owner);
+            if (ScanNextHop(ring[current], targetId, scanOwner) != next || scanOwner != owner) {
+                return false;
+            }
+            if (next == ring[current].id) {
+                break;
+            }
+            hops.push_back(std::make_pair(current, targetId));
+            current = std::lower_bound(ring.begin(), ring.end(), next,
+                                       [](const BenchNode& node, ChordId value) { return node.id < value; }) - ring.begin();
+            if (owner) {
+                break;
+            }
         }
+        return true;
+    }
 
-        Ipv4InterfaceAddress iaddr = ipv4->GetAddress(1,0);
-        return InetSocketAddress(iaddr.GetLocal(), 9);
+    // Nanosecondi di una passata
+    template <typename Body>
+    static double TimePass(Body body) {
+        auto start = std::chrono::steady_clock::now();
+        body();
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
     }
 
-    void InsertFiles() {
-        Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable>();
-        
-        Time startTime = Seconds(1.0);
-        
-        cout << "DEBUG: Inserimento di " << files.size() << " file nella rete" << endl;
-        
-        std::map<uint32_t, uint32_t> chordIdToIndex;
-        for (uint32_t i = 0; i < nodes.size(); i++) {
-            chordIdToIndex[nodes[i].chordId] = i;
+    // Ripercorre gli hop con nextHop
+    template <typename NextHop>
+    void ReplayHops(const std::vector<BenchNode>& ring, const std::vector<std::pair<uint32_t, ChordId>>& hops,
+                    NextHop nextHop) {
+        for (const auto& hop : hops) {
+            bool owner = false;
+            checksum += IdLow64(nextHop(ring[hop.first], hop.second, owner)) + owner;
         }
-        
-        for (uint32_t i = 0; i < files.size(); i++) {
-            uint32_t fileId = files[i];
-            uint32_t startNodeIndex = rng->GetInteger(0, numNodes - 1);
-            uint32_t responsibleChordId = findSuccessor(fileId);
-            
-            if (chordIdToIndex.find(responsibleChordId) == chordIdToIndex.end()) {
-                cout << "ERROR: ChordID " << responsibleChordId << " non trovato nella mappa!" << endl;
-                continue;
+    }
+
+    int RunRouting() {
+        static const uint32_t bits[] = {14, 16, 20, 24, 32, 48, 64, 128, 160};
+        cout << "Microbenchmark del prossimo hop: fino a " << numNodes << " nodi, " << numLookups
+             << " lookup per m, ID a " << CHORD_ID_BITS << " bit" << endl;
+        cout << std::setw(5) << "m" << std::setw(8) << "nodi" << std::setw(12) << "hop medi"
+             << std::setw(20) << "scansione ns/lookup" << std::setw(18) << "piatta ns/lookup" << endl;
+        for (uint32_t m : bits) {
+            if (m > CHORD_ID_BITS) {
+                break;
             }
-            uint32_t responsibleNodeIndex = chordIdToIndex[responsibleChordId];
-            
-            cout << "DEBUG: File " << fileId << " - Nodo di partenza: " << startNodeIndex 
-                 << " (ChordID: " << nodes[startNodeIndex].chordId << ")"
-                 << " - Nodo responsabile: " << responsibleNodeIndex 
-                 << " (ChordID: " << responsibleChordId << ")" << endl;
-            
-            if (startNodeIndex >= applications.size() || responsibleNodeIndex >= nodes.size()) {
-                cout << "ERROR: Indice nodo non valido in InsertFiles" << endl;
-                continue;
+            uint32_t n = m < 32 ? std::min<uint32_t>(numNodes, 1u << (m - 1)) : numNodes;
+            std::vector<BenchNode> ring = BuildRing(m, n);
+            std::vector<std::pair<uint32_t, ChordId>> hops;
+            for (uint32_t i = 0; i < numLookups; i++) {
+                if (!TraceLookup(ring, rng->GetInteger(0, n - 1), RandomId(rng, m), hops)) {
+                    cout << "ERRORE: con m=" << m << " le due ricerche scelgono hop diversi" << endl;
+                    return 1;
+                }
             }
-
-            Address targetAddr = getNodeAddress(responsibleNodeIndex);
-            if (targetAddr.IsInvalid()) {
-                cout << "ERROR: Indirizzo target non valido per il nodo " << responsibleNodeIndex << endl;
-                continue;
+            // Una passata di riscaldamento per ricerca, poi le due si alternano nell'ordine, così
+            // nessuna delle due trova sempre le cache preparate dall'altra
+            auto scanPass = [&]() { ReplayHops(ring, hops, ScanNextHop); };
+            auto flatPass = [&]() { ReplayHops(ring, hops, FlatNextHop); };
+            scanPass();
+            flatPass();
+            double scan = std::numeric_limits<double>::max();
+            double flat = std::numeric_limits<double>::max();
+            for (uint32_t r = 0; r < repetitions; r++) {
+                if (r % 2 == 0) {
+                    scan = std::min(scan, TimePass(scanPass));
+                    flat = std::min(flat, TimePass(flatPass));
+                } else {
+                    flat = std::min(flat, TimePass(flatPass));
+                    scan = std::min(scan, TimePass(scanPass));
+                }
             }
+            scan /= std::max<uint32_t>(numLookups, 1);
+            flat /= std::max<uint32_t>(numLookups, 1);
+            cout << std::setw(5) << m << std::setw(8) << n << std::setw(12) << std::fixed << std::setprecision(2)
+                 << (double)hops.size() / std::max<uint32_t>(numLookups, 1) << std::setw(20) << std::setprecision(1) << scan
+                 << std::setw(18) << flat << endl;
+            results.push_back({"next_hop_scan", m, scan});
+            results.push_back({"next_hop_flat", m, flat});
+        }
+        return 0;
+    }
 
-            uint32_t sNodeIndex = startNodeIndex;
-            uint32_t fId = fileId;
-            Address tAddr = targetAddr;
+    // Primitive della ChordNetwork su anelli di dimensione crescente, con m pari alla larghezza degli
+    // ID (al più 64 bit, perché le finger table di 100000 nodi restino in memoria)
+    void RunNetworkPrimitives() {
+        static const uint32_t sizes[] = {1000, 10000, 100000};
+        uint32_t m = std::min<uint32_t>(CHORD_ID_BITS, 64);
+        for (uint32_t n : sizes) {
+            ChordConfig config;
+            config.m = m;
+            config.numNodes = n;
+            config.numFiles = 0;
+            config.numLookups = 0;
+            config.engine = "analytic";
+            config.analyticDelay = "hops";
+            ChordNetwork network(config);
 
-            auto sendStoreMessage = [this, sNodeIndex, fId, tAddr]() {
-                if (sNodeIndex >= applications.size() || !applications[sNodeIndex]) {
-                    cout << "ERROR: Puntatore applicazione non valido" << endl;
-                    return;
-                }
-                
-                ChordMessage msg;
-                msg.type = ChordMessage::STORE_FILE;
-                msg.senderId = nodes[sNodeIndex].chordId;
-                msg.originId = nodes[sNodeIndex].chordId;   
-                msg.targetId = fId;
-                msg.hopCount = 0;
-                msg.success = false;
+            std::vector<ChordId> targets;
+            std::vector<uint32_t> origins;
+            for (uint32_t i = 0; i < numLookups; i++) {
+                targets.push_back(RandomId(rng, m));
+                origins.push_back(rng->GetInteger(0, n - 1));
+            }
 
-                Ptr<Packet> packet = Create<Packet>((uint8_t*)&msg, sizeof(ChordMessage));
-                if (packet && applications[sNodeIndex]->IsStarted()) {
-                    applications[sNodeIndex]->SendMessage(packet, tAddr);
-                    cout << "DEBUG: Inviato messaggio STORE_FILE per file " << fId 
-                         << " dal nodo " << sNodeIndex << " (ChordID: " << nodes[sNodeIndex].chordId << ")"
-                         << " al nodo responsabile" << endl;
-                } else {
-                    cout << "ERROR: Failed to create packet or application not started" << endl;
+            Record("find_successor", n, Measure(targets.size(), [&]() {
+                for (ChordId target : targets) {
+                    checksum += IdLow64(network.findSuccessor(target));
                 }
-            };
-
-            Simulator::Schedule(startTime + Seconds(0.1 * i), sendStoreMessage);
+            }));
+            std::vector<double> noRtt;
+            Record("init_finger_table", n, Measure(n, [&]() {
+                for (uint32_t i = 0; i < n; i++) {
+                    network.initializeFingerTable(i, noRtt);
+                    checksum += network.nodes[i].fingerTable.size();
+                }
+            }));
+            Record("find_next_hop", n, Measure(targets.size(), [&]() {
+                for (size_t k = 0; k < targets.size(); k++) {
+                    const ChordNode& node = network.nodes[origins[k]];
+                    bool owner = false;
+                    checksum += IdLow64(SelectNextHop(node.chordId, targets[k], network.analyticFingers[origins[k]],
+                                                      node.successorList, [](ChordId) { return true; }, owner));
+                }
+            }));
+            if (n == sizes[0]) {
+                // Lookup riusciti e falliti alternati, come li riportano applicazioni e motore analitico;
+                // ogni passata usa ID nuovi, altrimenti verrebbero scartati come duplicati
+                uint32_t lookupId = 0;
+                Record("update_stats", 0, Measure(numLookups, [&]() {
+                    for (uint32_t k = 0; k < numLookups; k++, lookupId++) {
+                        network.UpdateStats(k % 8 != 0, 1 + k % 12, lookupId, MicroSeconds(1000 + 37 * (k % 4096)),
+                                            k % 16 == 0);
+                    }
+                }));
+                checksum += network.stats.successfulLookups;
+            }
         }
     }
 
-    void SimulateNodeFailures() {
-        Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable>();
-        
-        Time startTime = Seconds(5.0);
-        
-        std::set<uint32_t> failedNodes;
-        
-        for (uint32_t i = 0; i < failingNodes; i++) {
-            uint32_t nodeIndex;
-            bool validNode = false;
+    void RunIdPrimitives() {
+        uint32_t m = std::min<uint32_t>(CHORD_ID_BITS, 64);
+        std::vector<ChordId> ids;
+        for (uint32_t i = 0; i < numLookups + 2; i++) {
+            ids.push_back(RandomId(rng, m));
+        }
+        Record("is_in_range", m, Measure(numLookups, [&]() {
+            for (uint32_t i = 0; i < numLookups; i++) {
+                checksum += IsInRingRange(ids[i], ids[i + 1], ids[i + 2]);
+            }
+        }));
 
-            while (!validNode) {
-                nodeIndex = rng->GetInteger(0, numNodes - 1);
-                if (nodes[nodeIndex].isAlive && failedNodes.find(nodeIndex) == failedNodes.end()) {
-                    validNode = true;
-                    failedNodes.insert(nodeIndex);
+        // Un messaggio per forma: solo campi fissi, successor list e trasferimento di chiavi
+        ChordMessage lookup;
+        lookup.type = ChordMessage::LOOKUP_REQUEST;
+        lookup.senderId = ids[0];
+        lookup.originId = ids[1];
+        lookup.targetId = ids[2];
+        lookup.hopCount = 5;
+        lookup.options = ChordMessage::OPT_NONCE;
+        lookup.nonce = 12345;
+        ChordMessage stabilize = lookup;
+        stabilize.type = ChordMessage::STABILIZE_REPLY;
+        stabilize.options = ChordMessage::OPT_PREDECESSOR | ChordMessage::OPT_SUCCESSOR_LIST;
+        stabilize.predecessorId = ids[3];
+        stabilize.successors.assign(ids.begin(), ids.begin() + 8);
+        ChordMessage transfer = lookup;
+        transfer.type = ChordMessage::KEY_TRANSFER;
+        transfer.options = ChordMessage::OPT_KEY_LIST;
+        transfer.keys.assign(ids.begin(), ids.begin() + ChordApplication::KEY_BATCH_SIZE);
+
+        const std::pair<const char*, const ChordMessage*> messages[] = {
+            {"lookup_request", &lookup}, {"stabilize_reply", &stabilize}, {"key_transfer", &transfer}};
+        uint32_t count = std::max<uint32_t>(numLookups / 10, 1);
+        for (const auto& entry : messages) {
+            const ChordMessage& msg = *entry.second;
+            uint32_t size = msg.successors.size() + msg.keys.size();
+            Record(std::string("serialize_") + entry.first, size, Measure(count, [&]() {
+                for (uint32_t i = 0; i < count; i++) {
+                    checksum += CreateMessagePacket(msg)->GetSize();
                 }
-            }
-            
-            uint32_t nIndex = nodeIndex;
-            
-            auto setNodeDown = [this, nIndex]() {
-                if (nIndex < nodes.size() && nIndex < applications.size()) {
-                    nodes[nIndex].isAlive = false;
-                    applications[nIndex]->SetAlive(false);
-                    cout << "INFO: Simulando fallimento del nodo " << nIndex << endl;
+            }));
+            Ptr<Packet> packet = CreateMessagePacket(msg);
+            Record(std::string("deserialize_") + entry.first, size, Measure(count, [&]() {
+                for (uint32_t i = 0; i < count; i++) {
+                    ChordHeader header;
+                    packet->PeekHeader(header);
+                    checksum += header.GetMessage().hopCount;
                 }
-            };
-            
-            Time failureTime = startTime + Seconds(rng->GetValue(0.0, 5.0));
-            Simulator::Schedule(failureTime, setNodeDown);
+            }));
         }
     }
 
-    void PerformLookups() {
-        Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable>();
-        
-        Time startTime = Seconds(10.0);
-        
-        uint32_t totalAttempts = 0;
-        uint32_t skippedDeadNodes = 0;
-        
-        std::map<uint32_t, uint32_t> chordIdToIndex;
-        for (uint32_t i = 0; i < nodes.size(); i++) {
-            chordIdToIndex[nodes[i].chordId] = i;
+    bool WriteResults(const std::string& filename) const {
+        std::ofstream file(filename);
+        if (!file.is_open()) {
+            cout << "ERRORE: Impossibile aprire il file " << filename << " per la scrittura" << endl;
+            return false;
         }
-        
-        for (uint32_t i = 0; i < filesForLookup.size(); i++) {
-            uint32_t fileId = filesForLookup[i];
-            uint32_t startNodeIndex = rng->GetInteger(0, numNodes - 1);
-            
-            totalAttempts++;
-            
-            if (startNodeIndex >= applications.size() || !applications[startNodeIndex]) {
-                cout << "ERROR: Indice nodo non valido in PerformLookups: " << startNodeIndex << endl;
-                continue;
+        file << "Benchmark,Param,NsPerOp" << endl;
+        for (const Result& result : results) {
+            file << result.name << "," << result.param << "," << result.nsPerOp << endl;
+        }
+        cout << "Risultati del microbenchmark salvati nel file " << filename << endl;
+        return true;
+    }
+
+    // Regressioni rispetto a una baseline scritta con --bench-csv: le misure oltre
+    // baseline * (1 + tolerance). Una misura assente dalla baseline (per esempio con un altro
+    // CHORD_ID_BITS) è un errore, come una baseline illeggibile: -1
+    int CheckBaseline(const std::string& filename, double tolerance) const {
+        std::ifstream file(filename);
+        if (!file.is_open()) {
+            cout << "ERRORE: Impossibile aprire la baseline " << filename << endl;
+            return -1;
+        }
+        std::map<std::pair<std::string, std::string>, double> baseline;
+        std::string line;
+        std::getline(file, line);
+        while (std::getline(file, line)) {
+            std::istringstream is(line);
+            std::string name, param, value;
+            if (std::getline(is, name, ',') && std::getline(is, param, ',') && std::getline(is, value)) {
+                baseline[std::make_pair(name, param)] = std::atof(value.c_str());
             }
-            
-            if (!nodes[startNodeIndex].isAlive) {
-                cout << "INFO: Skippo una lookup da un nodo down " << startNodeIndex 
-                     << " (ChordID: " << nodes[startNodeIndex].chordId << ")"
-                     << " per il file " << fileId << endl;
-                skippedDeadNodes++;
+        }
+
+        int regressions = 0;
+        uint32_t missing = 0;
+        for (const Result& result : results) {
+            auto it = baseline.find(std::make_pair(result.name, std::to_string(result.param)));
+            if (it == baseline.end()) {
+                missing++;
+                cout << "ERRORE: " << result.name << " (" << result.param << ") manca dalla baseline " << filename << endl;
                 continue;
             }
-            
-            uint32_t sNodeIndex = startNodeIndex;
-            uint32_t fId = fileId;
-            uint32_t lookupId = ChordApplication::nextLookupId++;
+            if (result.nsPerOp > it->second * (1.0 + tolerance)) {
+                regressions++;
+                cout << "REGRESSIONE: " << result.name << " (" << result.param << "): " << result.nsPerOp
+                     << " ns/op contro " << it->second << " della baseline" << endl;
+            }
+        }
+        if (missing > 0 || results.empty()) {
+            cout << "ERRORE: la baseline " << filename << " non copre tutte le misure; va rigenerata con --bench-csv"
+                 << endl;
+            return -1;
+        }
+        cout << "Confrontate " << results.size() << " misure con la baseline " << filename << " (tolleranza "
+             << tolerance * 100 << "%): " << regressions << " regressioni" << endl;
+        return regressions;
+    }
 
-            auto startLookup = [this, sNodeIndex, fId, lookupId]() {
-                if (sNodeIndex < applications.size() && applications[sNodeIndex] && applications[sNodeIndex]->IsStarted()) {
-                    cout << "INFO: Inizio lookup " << lookupId << " dal nodo " << sNodeIndex 
-                         << " (ChordID: " << nodes[sNodeIndex].chordId << ")"
-                         << " per il file " << fId << endl;
-                    applications[sNodeIndex]->PerformLookup(fId, timeoutDuration, lookupId);
-                    stats.totalLookups++;
-                }
-            };
+public:
+    ChordBench(uint32_t nodes, uint32_t lookups, uint32_t repeat)
+        : numNodes(nodes), numLookups(lookups), repetitions(repeat), rng(CreateObject<UniformRandomVariable>()),
+          checksum(0) {}
 
-            Simulator::Schedule(startTime + Seconds(0.1 * i), startLookup);
+    // 0 se tutto è andato a buon fine, 1 per un errore, 2 se ci sono regressioni
+    int Run(const std::string& csvFile, const std::string& baselineFile, double tolerance) {
+        if (RunRouting() != 0) {
+            return 1;
         }
-        
-        cout << "INFO: Statistiche lookup:" << endl;
-        cout << "  Tentativi totali: " << totalAttempts << endl;
-        cout << "  Tentativi saltati a causa di nodi down: " << skippedDeadNodes << endl;
+        cout << "Primitive (ID a " << CHORD_ID_BITS << " bit, " << numLookups << " operazioni):" << endl;
+        RunNetworkPrimitives();
+        RunIdPrimitives();
+        NS_LOG_DEBUG("Checksum del microbenchmark: " << checksum);
+        if (!csvFile.empty() && !WriteResults(csvFile)) {
+            return 1;
+        }
+        if (!baselineFile.empty()) {
+            int regressions = CheckBaseline(baselineFile, tolerance);
+            return regressions < 0 ? 1 : (regressions > 0 ? 2 : 0);
+        }
+        return 0;
     }
 };
 
 int main(int argc, char *argv[]) {
-    uint32_t m = 14; 
-    uint32_t numNodes = 10;     
-    uint32_t numFiles = 5;
-    uint32_t numLookups = 3; 
-    uint32_t failingNodes = 0;
+    ChordConfig config;
     uint32_t seed = 1;
+    uint32_t verbose = 0;
     std::string csvFilename = "chord_stats.csv";  
+    std::string jsonFilename = "";
+    std::string sweep = "";
+    std::string sweepDir = "chord_sweep";
+    uint32_t reps = 3;
+    uint32_t jobs = 0;
+    bool bench = false;
+    uint32_t benchNodes = 8192;
+    uint32_t benchLookups = 100000;
+    uint32_t benchRepetitions = 5;
+    std::string benchCsv = "";
+    std::string benchBaseline = "";
+    double benchTolerance = 0.25;
 
     CommandLine cmd;
-    cmd.AddValue("m", "Numero di bit per lo spazio degli ID", m);
-    cmd.AddValue("nodes", "Numero di nodi", numNodes);
-    cmd.AddValue("files", "Numero di file da inserire", numFiles);
-    cmd.AddValue("lookups", "Numero di lookup da eseguire", numLookups);
-    cmd.AddValue("failing", "Numero di nodi che falliranno", failingNodes);
+    cmd.AddValue("m", "Numero di bit per lo spazio degli ID", config.m);
+    cmd.AddValue("nodes", "Numero di nodi", config.numNodes);
+    cmd.AddValue("files", "Numero di file da inserire", config.numFiles);
+    cmd.AddValue("lookups", "Numero di lookup da eseguire", config.numLookups);
+    cmd.AddValue("failing", "Numero di nodi che falliranno", config.failingNodes);
+    cmd.AddValue("succ", "Numero di successori mantenuti da ogni nodo", config.successorListSize);
+    cmd.AddValue("hop-timeout", "Timeout iniziale in secondi per la conferma di ogni hop (0 = disattivato)", config.hopTimeout);
+    cmd.AddValue("lookup-mode", "Modalità di lookup: recursive, iterative, semi", config.lookupMode);
+    cmd.AddValue("alpha", "Richieste FIND_NEXT_HOP in parallelo nei lookup iterativi", config.alpha);
+    cmd.AddValue("pns", "Candidati per intervallo tra cui scegliere ogni finger per RTT (1 = disattivato)", config.pnsCandidates);
+    cmd.AddValue("prs", "Sceglie il prossimo hop bilanciando avanzamento nell'anello e RTT", config.prs);
+    cmd.AddValue("cache", "Voci della cache delle posizioni delle chiavi per nodo (0 = disattivata)", config.cacheSize);
+    cmd.AddValue("cache-ttl", "Durata in secondi delle voci della cache delle posizioni", config.cacheTtl);
+    cmd.AddValue("replicas", "Numero di copie di ogni chiave (responsabile e successori)", config.replicas);
+    cmd.AddValue("stabilize", "Periodo in secondi di stabilize/notify (0 = disattivato)", config.stabilizePeriod);
+    cmd.AddValue("fix-fingers", "Periodo in secondi di fix_fingers (0 = disattivato)", config.fixFingersPeriod);
+    cmd.AddValue("check-pred", "Periodo in secondi di check_predecessor (0 = disattivato)", config.checkPredecessorPeriod);
+    cmd.AddValue("joining", "Numero di nodi che entrano nell'anello durante la simulazione", config.joiningNodes);
+    cmd.AddValue("join-start", "Istante in secondi della prima ondata di ingressi", config.joinStart);
+    cmd.AddValue("join-wave", "Numero di nodi che entrano in ogni ondata", config.joinWave);
+    cmd.AddValue("join-interval", "Secondi tra due ondate di ingressi", config.joinInterval);
+    cmd.AddValue("churn", "Modello di churn: none, exp, pareto, weibull", config.churn);
+    cmd.AddValue("session", "Durata media in secondi delle sessioni attive", config.sessionTime);
+    cmd.AddValue("downtime", "Durata media in secondi delle assenze", config.downTime);
+    cmd.AddValue("churn-shape", "Parametro di forma di Pareto e Weibull", config.churnShape);
+    cmd.AddValue("churn-start", "Istante in secondi da cui iniziano le sessioni dei nodi iniziali", config.churnStart);
+    cmd.AddValue("timeseries", "Nome del file CSV per la serie temporale dei lookup (vuoto = disattivato)", config.timeSeriesFile);
+    cmd.AddValue("ts-interval", "Ampiezza in secondi degli intervalli della serie temporale", config.timeSeriesInterval);
+    cmd.AddValue("node-stats", "Nome del file CSV per i contatori per nodo e per tipo di messaggio (vuoto = disattivato)", config.nodeStatsFile);
+    cmd.AddValue("node-stats-interval", "Secondi tra due istantanee dei contatori per nodo (0 = solo a fine simulazione)", config.nodeStatsInterval);
+    cmd.AddValue("engine", "Motore di simulazione: packet, analytic", config.engine);
+    cmd.AddValue("analytic-delay", "Ritardi del motore analitico: underlay, hops", config.analyticDelay);
+    cmd.AddValue("hop-latency", "Ritardo in secondi di ogni hop con --analytic-delay=hops", config.hopLatency);
+    cmd.AddValue("mpi", "Simulazione distribuita su tutti i rank MPI (richiede ns-3 compilato con MPI)", config.mpi);
+    cmd.AddValue("partition", "Assegnazione dei nodi ai rank MPI: block, roundrobin", config.partition);
+    cmd.AddValue("topology", "Generatore dell'underlay: default, transit-stub, ba, lan, file", config.topology);
+    cmd.AddValue("topo-file", "Lista di collegamenti \"a b [ritardo_ms] [banda]\" per --topology=file", config.topologyFile);
+    cmd.AddValue("link-delay", "Ritardo in secondi dei collegamenti dell'underlay", config.linkDelay);
+    cmd.AddValue("link-rate", "Banda dei collegamenti dell'underlay", config.linkRate);
+    cmd.AddValue("ba-links", "Collegamenti di ogni nuovo nodo (o router) con preferential attachment", config.baLinks);
+    cmd.AddValue("domain-size", "Nodi di ogni dominio stub o segmento CSMA", config.domainSize);
+    cmd.AddValue("transit-nodes", "Nodi del nucleo transit-stub (0 = uno ogni 4 domini stub)", config.transitNodes);
+    cmd.AddValue("save-ring", "File in cui salvare l'anello costruito (vuoto = disattivato)", config.saveRing);
+    cmd.AddValue("load-ring", "Istantanea dell'anello da cui ripartire al posto della costruzione", config.loadRing);
+    cmd.AddValue("arrival", "Processo di arrivo dei lookup: fixed, constant, poisson, bursty", config.arrival);
+    cmd.AddValue("rate", "Tasso aggregato di lookup al secondo (arrivi open-loop)", config.rate);
+    cmd.AddValue("warmup", "Secondi di warm-up esclusi dalle statistiche", config.warmup);
+    cmd.AddValue("duration", "Durata in secondi della finestra di misura (0 = --lookups lookup misurati)", config.duration);
+    cmd.AddValue("burst-on", "Durata in secondi delle fasi attive del traffico bursty", config.burstOn);
+    cmd.AddValue("burst-off", "Durata in secondi delle pause del traffico bursty", config.burstOff);
+    cmd.AddValue("popularity", "Popolarità delle chiavi: uniform, zipf, hotset, trace", config.popularity);
+    cmd.AddValue("zipf-alpha", "Esponente della distribuzione di Zipf", config.zipfAlpha);
+    cmd.AddValue("hot-fraction", "Frazione dei file che forma l'insieme caldo", config.hotFraction);
+    cmd.AddValue("hot-prob", "Probabilità che un lookup cerchi un file dell'insieme caldo", config.hotProbability);
+    cmd.AddValue("trace", "File con le chiavi da cercare, una per riga (popolarità trace)", config.traceFile);
+    cmd.AddValue("keys", "File con i nomi dei file da inserire, uno per riga (sostituisce --files)", config.keysFile);
     cmd.AddValue("seed", "Seed for random number generator", seed);
     cmd.AddValue("csv", "Nome del file CSV per le statistiche", csvFilename);
+    cmd.AddValue("json", "Nome del file JSON per gli istogrammi di latenza e hop (vuoto = disattivato)", jsonFilename);
+    cmd.AddValue("sweep", "Campagna di simulazioni: nome=v1,v2;nome=v1,... con i parametri da variare (vuoto = singola simulazione)", sweep);
+    cmd.AddValue("reps", "Ripetizioni di ogni configurazione della campagna, con seed consecutivi da --seed", reps);
+    cmd.AddValue("jobs", "Simulazioni della campagna eseguite in parallelo (0 = una per core)", jobs);
+    cmd.AddValue("sweep-dir", "Directory dei risultati della campagna", sweepDir);
+    cmd.AddValue("bench", "Esegue il microbenchmark delle primitive di instradamento invece della simulazione", bench);
+    cmd.AddValue("bench-nodes", "Nodi dell'anello sintetico del microbenchmark", benchNodes);
+    cmd.AddValue("bench-lookups", "Lookup misurati per ogni m e operazioni per primitiva nel microbenchmark", benchLookups);
+    cmd.AddValue("bench-repetitions", "Passate misurate per ogni microbenchmark, dopo una di riscaldamento", benchRepetitions);
+    cmd.AddValue("bench-csv", "File CSV in cui salvare i risultati del microbenchmark (vuoto = disattivato)", benchCsv);
+    cmd.AddValue("bench-baseline", "CSV di un microbenchmark precedente con cui cercare regressioni", benchBaseline);
+    cmd.AddValue("bench-tolerance", "Rallentamento relativo oltre il quale una misura è una regressione", benchTolerance);
+    cmd.AddValue("verbose", "Livello di log (0=nessuno, 1=warning, 2=messaggi, 3=routing, 4=tutto)", verbose);
     cmd.Parse(argc, argv);
 
+    // Con verbose=0 nessun messaggio per pacchetto viene formattato; nelle build ottimizzate
+    // di ns-3 le macro NS_LOG vengono eliminate del tutto in compilazione
+    if (verbose > 0) {
+        static const LogLevel levels[] = {LOG_LEVEL_WARN, LOG_LEVEL_INFO, LOG_LEVEL_LOGIC, LOG_LEVEL_ALL};
+        LogLevel level = levels[std::min(verbose, (uint32_t)4) - 1];
+        LogComponentEnable("ChordProtocol", (LogLevel)(level | LOG_PREFIX_TIME | LOG_PREFIX_NODE));
+    }
+
+    if (bench) {
+        if (benchTolerance < 0) {
+            cout << "ERRORE: --bench-tolerance non può essere negativa" << endl;
+            return 1;
+        }
+        RngSeedManager::SetSeed(seed);
+        ChordBench suite(std::max<uint32_t>(benchNodes, 2), benchLookups, std::max<uint32_t>(benchRepetitions, 1));
+        return suite.Run(benchCsv, benchBaseline, benchTolerance);
+    }
+
+    // Servono almeno tanti ID quanti nodi; spazi oltre CHORD_ID_BITS richiedono di ricompilare
+    if (config.m == 0 || config.m > CHORD_ID_BITS
+        || (config.m < 64 && (1ull << config.m) < (uint64_t)config.numNodes + config.joiningNodes)) {
+        cout << "ERRORE: --m deve essere compreso tra 1 e " << CHORD_ID_BITS
+             << " (-DCHORD_ID_BITS per spazi più ampi) e offrire almeno un ID per nodo" << endl;
+        return 1;
+    }
+    if (!config.keysFile.empty()) {
+        std::ifstream keys(config.keysFile);
+        std::string line;
+        while (std::getline(keys, line)) {
+            if (!line.empty() && line[0] != '#') {
+                config.keyNames.push_back(line);
+            }
+        }
+        if (config.keyNames.empty()) {
+            cout << "ERRORE: Impossibile leggere chiavi dal file " << config.keysFile << endl;
+            return 1;
+        }
+        config.numFiles = config.keyNames.size();
+    }
+
+    if (config.arrival != "fixed" && config.arrival != "constant" && config.arrival != "poisson" && config.arrival != "bursty") {
+        cout << "ERRORE: processo di arrivo sconosciuto: " << config.arrival << endl;
+        return 1;
+    }
+    if (config.arrival != "fixed" && config.rate <= 0) {
+        cout << "ERRORE: --rate deve essere positivo" << endl;
+        return 1;
+    }
+    if (config.arrival == "bursty" && (config.burstOn <= 0 || config.burstOff < 0)) {
+        cout << "ERRORE: --burst-on deve essere positivo e --burst-off non negativo" << endl;
+        return 1;
+    }
+
+    if (config.successorListSize == 0 || config.hopTimeout < 0) {
+        cout << "ERRORE: --succ deve essere almeno 1 e --hop-timeout non negativo" << endl;
+        return 1;
+    }
+    if (config.lookupMode != "recursive" && config.lookupMode != "iterative" && config.lookupMode != "semi") {
+        cout << "ERRORE: modalità di lookup sconosciuta: " << config.lookupMode << endl;
+        return 1;
+    }
+    if (config.alpha == 0 || config.alpha > 254) {
+        cout << "ERRORE: --alpha deve essere compreso tra 1 e 254" << endl;
+        return 1;
+    }
+    if (config.engine != "packet" && config.engine != "analytic") {
+        cout << "ERRORE: motore sconosciuto: " << config.engine << endl;
+        return 1;
+    }
+    if ((config.analyticDelay != "underlay" && config.analyticDelay != "hops") || config.hopLatency <= 0) {
+        cout << "ERRORE: --analytic-delay deve essere underlay o hops e --hop-latency positivo" << endl;
+        return 1;
+    }
+    // Il motore analitico modella solo il routing ricorsivo su tabelle statiche con guasti permanenti
+    if (config.engine == "analytic"
+        && (config.joiningNodes > 0 || config.churn != "none" || config.stabilizePeriod > 0
+            || config.fixFingersPeriod > 0 || config.checkPredecessorPeriod > 0 || config.lookupMode != "recursive"
+            || config.cacheSize > 0 || config.pnsCandidates > 1 || config.prs || !config.nodeStatsFile.empty())) {
+        cout << "ERRORE: il motore analitico non supporta ingressi, churn, manutenzione, lookup iterativi, cache, "
+             << "PNS/PRS e contatori per nodo" << endl;
+        return 1;
+    }
+    if (config.nodeStatsInterval < 0) {
+        cout << "ERRORE: --node-stats-interval non può essere negativo" << endl;
+        return 1;
+    }
+    if (config.popularity != "uniform" && config.popularity != "zipf" && config.popularity != "hotset"
+        && config.popularity != "trace") {
+        cout << "ERRORE: modello di popolarità sconosciuto: " << config.popularity << endl;
+        return 1;
+    }
+    if (config.zipfAlpha < 0 || config.hotFraction <= 0 || config.hotFraction > 1
+        || config.hotProbability < 0 || config.hotProbability > 1) {
+        cout << "ERRORE: --zipf-alpha non negativo, --hot-fraction in (0, 1] e --hot-prob in [0, 1]" << endl;
+        return 1;
+    }
+    if (config.popularity == "trace" && config.traceFile.empty()) {
+        cout << "ERRORE: --popularity=trace richiede --trace" << endl;
+        return 1;
+    }
+    if (config.popularity == "trace") {
+        std::ifstream trace(config.traceFile);
+        std::string line;
+        while (std::getline(trace, line)) {
+            if (!line.empty() && line[0] != '#') {
+                config.traceKeys.push_back(line);
+            }
+        }
+        if (config.traceKeys.empty()) {
+            cout << "ERRORE: Impossibile leggere chiavi dalla traccia " << config.traceFile << endl;
+            return 1;
+        }
+    }
+    if (config.cacheTtl <= 0) {
+        cout << "ERRORE: --cache-ttl deve essere positivo" << endl;
+        return 1;
+    }
+    if (config.pnsCandidates == 0) {
+        cout << "ERRORE: --pns deve essere almeno 1" << endl;
+        return 1;
+    }
+    if (config.replicas == 0 || config.replicas > 255) {
+        cout << "ERRORE: --replicas deve essere compreso tra 1 e 255" << endl;
+        return 1;
+    }
+    if (config.replicas - 1 > config.successorListSize) {
+        cout << "INFO: --succ portato a " << config.replicas - 1 << " per contenere le repliche" << endl;
+        config.successorListSize = config.replicas - 1;
+    }
+    if (config.stabilizePeriod < 0 || config.fixFingersPeriod < 0 || config.checkPredecessorPeriod < 0) {
+        cout << "ERRORE: i periodi di manutenzione non possono essere negativi" << endl;
+        return 1;
+    }
+    if (config.churn != "none" && config.churn != "exp" && config.churn != "pareto" && config.churn != "weibull") {
+        cout << "ERRORE: modello di churn sconosciuto: " << config.churn << endl;
+        return 1;
+    }
+    if (config.churn != "none" && (config.sessionTime <= 0 || config.downTime <= 0
+                                   || (config.churn == "pareto" && config.churnShape <= 1)
+                                   || (config.churn == "weibull" && config.churnShape <= 0))) {
+        cout << "ERRORE: --session e --downtime devono essere positivi, --churn-shape > 1 per pareto e > 0 per weibull" << endl;
+        return 1;
+    }
+    if (config.timeSeriesInterval <= 0) {
+        cout << "ERRORE: --ts-interval deve essere positivo" << endl;
+        return 1;
+    }
+    if (config.joiningNodes > 0 && (config.joinWave == 0 || config.joinStart < 0 || config.joinInterval < 0)) {
+        cout << "ERRORE: --join-wave deve essere almeno 1, --join-start e --join-interval non negativi" << endl;
+        return 1;
+    }
+
+    if (config.topology != "default" && config.topology != "transit-stub" && config.topology != "ba"
+        && config.topology != "lan" && config.topology != "file") {
+        cout << "ERRORE: generatore di topologia sconosciuto: " << config.topology << endl;
+        return 1;
+    }
+    if (config.linkDelay <= 0 || config.baLinks == 0 || config.domainSize == 0) {
+        cout << "ERRORE: --link-delay deve essere positivo, --ba-links e --domain-size almeno 1" << endl;
+        return 1;
+    }
+    uint64_t linkBitRate = 0;
+    if (!TopologyGenerator::ParseRate(config.linkRate, linkBitRate)) {
+        cout << "ERRORE: --link-rate non valida: " << config.linkRate << " (es. 10Mbps)" << endl;
+        return 1;
+    }
+    if (config.topology == "file") {
+        UnderlayTopology topology;
+        std::string error;
+        if (!TopologyGenerator::LoadEdgeList(config.topologyFile, config.linkDelay, linkBitRate, topology, error)) {
+            cout << "ERRORE: " << error << endl;
+            return 1;
+        }
+        // Con il motore analitico i nodi del file sono i router e gli altri nodi vi si collegano
+        uint32_t totalNodes = config.numNodes + config.joiningNodes;
+        if (config.engine == "analytic" ? topology.numNodes > std::min(totalNodes, (uint32_t)2048)
+                                        : topology.numNodes != totalNodes) {
+            cout << "ERRORE: la topologia " << config.topologyFile << " ha " << topology.numNodes << " nodi, "
+                 << (config.engine == "analytic" ? "al più 2048 e non più dei nodi simulati con il motore analitico"
+                                                 : "ne servono esattamente --nodes + --joining") << endl;
+            return 1;
+        }
+    }
+    if (!config.loadRing.empty() || !config.saveRing.empty()) {
+        if (config.engine != "packet") {
+            cout << "ERRORE: --save-ring e --load-ring richiedono il motore a pacchetti" << endl;
+            return 1;
+        }
+    }
+    if (!config.loadRing.empty()) {
+        RingSnapshot snapshot;
+        std::string error;
+        if (!snapshot.Open(config.loadRing, error) || !snapshot.Matches(config, error)) {
+            cout << "ERRORE: " << error << endl;
+            return 1;
+        }
+    }
+    if (config.partition != "block" && config.partition != "roundrobin") {
+        cout << "ERRORE: partizionatore sconosciuto: " << config.partition << endl;
+        return 1;
+    }
+    if (config.mpi) {
+#ifndef NS3_MPI
+        cout << "ERRORE: --mpi richiede ns-3 configurato con --enable-mpi" << endl;
+        return 1;
+#else
+        // Ogni rank deve eseguire gli stessi passi: le funzioni che agiscono su nodi remoti
+        // o scrivono file per nodo non sono distribuite
+        if (!sweep.empty() || config.engine != "packet" || config.joiningNodes > 0 || config.churn != "none"
+            || !config.timeSeriesFile.empty() || !config.nodeStatsFile.empty()) {
+            cout << "ERRORE: --mpi non supporta --sweep, il motore analitico, ingressi, churn, serie temporale "
+                 << "e contatori per nodo" << endl;
+            return 1;
+        }
+        GlobalValue::Bind("SimulatorImplementationType", StringValue("ns3::DistributedSimulatorImpl"));
+        MpiInterface::Enable(&argc, &argv);
+        // Solo il rank 0 scrive a console e nei file; gli altri eseguono gli stessi passi
+        // perché le statistiche sono sommate con operazioni collettive
+        if (MpiInterface::GetSystemId() != 0) {
+            cout.rdbuf(nullptr);
+            csvFilename = "/dev/null";
+            if (!jsonFilename.empty()) {
+                jsonFilename = "/dev/null";
+            }
+        }
+#endif
+    }
+
+    if (!sweep.empty()) {
+        ChordSweep campaign(sweep, reps, seed, jobs, sweepDir);
+        if (!campaign.Prepare(argc, argv)) {
+            return 1;
+        }
+        return campaign.Execute() == 0 ? 0 : 2;
+    }
+
     RngSeedManager::SetSeed(seed);
     
-    ChordNetwork network(m, numNodes, numFiles, numLookups, failingNodes);
+    ChordNetwork network(config);
+    if (!config.saveRing.empty()) {
+        network.SaveRing(config.saveRing);
+    }
     network.StartSimulation();
 
+    auto wallStart = std::chrono::steady_clock::now();
     Simulator::Run();
+    network.SetWallClock(std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count());
+    network.ReduceStatistics();
     network.PrintStatistics();
     network.WriteStatisticsToCSV(csvFilename);
+    if (!jsonFilename.empty()) {
+        network.WriteStatisticsToJSON(jsonFilename);
+    }
+    network.WriteNodeStats();
     Simulator::Destroy();
+#ifdef NS3_MPI
+    if (config.mpi) {
+        MpiInterface::Disable();
+    }
+#endif
 
     return 0;
 } 
\ No newline at end of file
@@ -81,7 +81,7 @@ for NODES in "${NODES_ARRAY[@]}"; do
             CONFIG_RESULTS="$CONFIG_DIR/results.csv"
             
             # Intestazione del file CSV di configurazione
-            echo "NumNodes,NumFiles,NumLookups,FailingNodes,TotalLookups,SuccessfulLookups,FailedLookups,SuccessRate,AverageHops,MinHops,MaxHops,TheoreticalAverage" > $CONFIG_RESULTS
+            echo "NumNodes,NumFiles,NumLookups,FailingNodes,TotalLookups,SuccessfulLookups,FailedLookups,SuccessRate,AverageHops,MinHops,MaxHops,TheoreticalAverage,OfferedLoad,Throughput,LatencyMeanMs,LatencyP50Ms,LatencyP90Ms,LatencyP99Ms,LatencyP999Ms,LatencyMaxMs,TimedOutLookups,ControlMessages,ControlBytes,ControlBytesPerNodePerSec,JoinedNodes,JoinLatencyMeanMs,JoinLatencyP99Ms,KeysTransferred,KeyTransferBytes,ChurnDepartures,ChurnRejoins,Replicas,StoredKeys,ReplicaMessages,ReplicaBytes,LookupMode,Alpha,LookupMessages,LookupBytes,PnsCandidates,Prs,CacheSize,CacheHits,Popularity,LoadMaxMean,LoadGini,ServedMaxMean,ServedGini,Engine,Ranks,WallClockS,Topology" > $CONFIG_RESULTS
             
             # Esegui la simulazione NUM_REPETITIONS volte
             for (( i=1; i<=$NUM_REPETITIONS; i++ )); do
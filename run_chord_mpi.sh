@@ -0,0 +1,86 @@
+#!/bin/bash
+
+# Script per confrontare il tempo reale della simulazione Chord sequenziale con quello
+# della simulazione distribuita con MPI su un numero crescente di processi
+# Uso: ./run_chord_mpi.sh [numero_nodi] [lista_processi]
+# Esempio: ./run_chord_mpi.sh 3200 "2 4 8"
+# Richiede ns-3 configurato con --enable-mpi
+
+# Numero di nodi e numeri di processi predefiniti
+NODES=3200
+RANKS_LIST="2 4"
+
+if [ $# -ge 1 ]; then
+    NODES=$1
+fi
+if [ $# -ge 2 ]; then
+    RANKS_LIST=$2
+fi
+
+# Percorso del programma Chord
+CHORD_PATH="scratch/new_chord/chord.cc"
+
+# Percorso di ns-3 (relativo alla home dell'utente)
+NS3_DIR="ns-allinone-3.43/ns-3.43"
+
+# Parametri comuni a tutte le esecuzioni
+ARGS="--m=20 --nodes=$NODES --files=1000 --lookups=1000 --failing=0 --arrival=poisson --rate=100 --seed=1"
+
+cd ~/$NS3_DIR
+if [ ! -f "$CHORD_PATH" ]; then
+    echo "ERRORE: Il file $CHORD_PATH non esiste!"
+    echo "Assicurati che il file chord.cc sia nella directory scratch/new_chord/"
+    exit 1
+fi
+cd - > /dev/null
+
+# Crea directory per i risultati
+RESULTS_DIR="chord_mpi_results"
+mkdir -p $RESULTS_DIR
+ABSOLUTE_RESULTS_DIR="$(pwd)/$RESULTS_DIR"
+
+# Valore della colonna indicata (per nome) nell'ultima riga di un file CSV
+csv_value() {
+    awk -F, -v name="$2" 'NR==1 {for (i=1; i<=NF; i++) if ($i==name) col=i} END {print $col}' "$1"
+}
+wall_clock() {
+    csv_value "$1" WallClockS
+}
+success_rate() {
+    csv_value "$1" SuccessRate
+}
+
+echo "Esecuzione sequenziale con $NODES nodi"
+cd ~/$NS3_DIR
+./ns3 run "scratch/new_chord/chord $ARGS --csv=$ABSOLUTE_RESULTS_DIR/seq.csv"
+cd - > /dev/null
+
+if [ ! -f "$RESULTS_DIR/seq.csv" ]; then
+    echo "ERRORE: esecuzione sequenziale fallita"
+    exit 1
+fi
+SEQ_TIME=$(wall_clock "$RESULTS_DIR/seq.csv")
+
+SUMMARY="$RESULTS_DIR/speedup.csv"
+echo "Ranks,WallClockS,Speedup,Efficiency,SuccessRate" > $SUMMARY
+echo "1,$SEQ_TIME,1,1,$(success_rate "$RESULTS_DIR/seq.csv")" >> $SUMMARY
+
+for RANKS in $RANKS_LIST; do
+    echo "Esecuzione distribuita con $RANKS processi"
+    RANK_CSV="$ABSOLUTE_RESULTS_DIR/mpi_np${RANKS}.csv"
+
+    cd ~/$NS3_DIR
+    ./ns3 run scratch/new_chord/chord --command-template="mpirun -np $RANKS %s $ARGS --mpi --csv=$RANK_CSV"
+    cd - > /dev/null
+
+    if [ ! -f "$RANK_CSV" ]; then
+        echo "Warning: $RANK_CSV not found"
+        continue
+    fi
+    MPI_TIME=$(wall_clock "$RANK_CSV")
+    awk -v r=$RANKS -v s=$SEQ_TIME -v t=$MPI_TIME -v ok=$(success_rate "$RANK_CSV") \
+        'BEGIN {printf "%d,%s,%.3f,%.3f,%s\n", r, t, s/t, s/t/r, ok}' >> $SUMMARY
+done
+
+echo "Confronto salvato in $SUMMARY"
+column -s, -t < $SUMMARY